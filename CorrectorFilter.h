@@ -0,0 +1,111 @@
+#ifndef _CORRECTOR_FILTER_H_
+#define _CORRECTOR_FILTER_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+#include "TageRandom.h"
+
+#define CF_CTR_MAX 31
+#define CF_CTR_BITS 6
+#define CF_TAG_WIDTH 7
+#define CF_CTR_NUM 236
+
+class CorrectorFilter{
+public:
+  int8_t ctr[CF_CTR_NUM]; // 6 bits
+  uint8_t tag[CF_CTR_NUM]; // 7 bits 
+  uint32_t cf_idx;
+  uint32_t cf_tag;
+  void init(){
+    for(int i = 0; i < CF_CTR_NUM; i++){
+      ctr[i] = 0;
+      tag[i] = 0;
+    }
+    cf_idx = 0;
+    cf_tag = 0;
+  }
+
+  void save(StateWriter &w) const{
+    for(int i = 0; i < CF_CTR_NUM; i++){
+      w.put((uint8_t)ctr[i], CF_CTR_BITS);
+      w.put(tag[i], CF_TAG_WIDTH);
+    }
+    w.put(cf_idx, 32);
+    w.put(cf_tag, 32);
+  }
+
+  void load(StateReader &r){
+    for(int i = 0; i < CF_CTR_NUM; i++){
+      UINT32 v = r.get(CF_CTR_BITS);
+      ctr[i] = (int8_t)(v << (8 - CF_CTR_BITS)) >> (8 - CF_CTR_BITS); // sign extend
+      tag[i] = r.get(CF_TAG_WIDTH);
+    }
+    cf_idx = r.get(32);
+    cf_tag = r.get(32);
+  }
+
+  // both slots the prediction may use, TAGE's result not being known yet
+  void prefetch(UINT32 pc) const{
+    uint32_t idx = (pc * 251) % CF_CTR_NUM;
+    uint32_t idx1 = (pc * 251 + 1) % CF_CTR_NUM;
+    __builtin_prefetch(&ctr[idx]);
+    __builtin_prefetch(&tag[idx]);
+    __builtin_prefetch(&ctr[idx1]);
+    __builtin_prefetch(&tag[idx1]);
+  }
+
+  bool cf_predictor(UINT32 pc, bool tage_result, bool highconf){
+    if(highconf) return tage_result;
+    uint32_t cf_idx = (pc * 251  + (int)tage_result) % CF_CTR_NUM;
+    uint32_t cf_tag = (pc >> 6) & ((1<<CF_TAG_WIDTH) - 1); 
+    if(tag[cf_idx] != cf_tag){
+      return tage_result;
+    }
+    else{
+        if(abs(2 * ctr[cf_idx] + 1) >= 17){
+          return ctr[cf_idx] >= 0;
+        }
+    }
+    return tage_result;
+  }
+
+  void cf_update(UINT32 pc, bool tage_result, bool resolveDir, bool highconf, TageRandom &rng){
+    if(highconf) return;
+    // tage is right, and tag not hit
+    if(tag[cf_idx] != cf_tag && tage_result == resolveDir){
+      return;
+    }
+    // tage is incorrect, tag hit
+    if(tag[cf_idx] == cf_tag){
+      if(resolveDir == TAKEN && ctr[cf_idx] < CF_CTR_MAX ){
+        ctr[cf_idx]++;
+      }
+      else if(resolveDir == NOT_TAKEN && ctr[cf_idx] > -CF_CTR_MAX - 1){
+        ctr[cf_idx]--;
+      }
+      return;
+    }
+    // tage is incorrect, tag not hit
+    if((rng.next() & 15)) return;
+
+    // ctr is 0 or -1 , or the cf result is the same to tage
+    if( (abs(2 * ctr[cf_idx] + 1) == 1) || ((ctr[cf_idx] >= 0) == tage_result)){
+      tag[cf_idx] = cf_tag;
+      ctr[cf_idx] = resolveDir? 0: -1;
+      return;
+    }
+
+    // else,update ctr
+    if((rng.next() & 7) == 0){
+      if(tage_result == TAKEN && ctr[cf_idx] < CF_CTR_MAX ){
+        ctr[cf_idx]++;
+      }
+      else if(tage_result == NOT_TAKEN && ctr[cf_idx] > -CF_CTR_MAX - 1){
+        ctr[cf_idx]--;
+      }
+      return;
+    }
+  }
+};
+
+#endif
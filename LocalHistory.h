@@ -0,0 +1,57 @@
+#ifndef _LOCAL_HISTORY_H_
+#define _LOCAL_HISTORY_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+
+// Per-branch direction histories: 2^LOG_ENTRIES untagged registers of
+// HIST_BITS outcomes each, selected by a hash of the PC, newest outcome in
+// bit 0. Branches sharing a register simply share their history.
+template<int LOG_ENTRIES, int HIST_BITS>
+class LocalHistoryTable{
+public:
+  static const UINT32 ENTRIES = 1u << LOG_ENTRIES;
+  static_assert(HIST_BITS <= 32, "a local history is one UINT32");
+
+  void init(){
+    memset(hist, 0, sizeof(hist));
+  }
+
+  static UINT32 index(UINT32 PC){ return (PC ^ (PC >> LOG_ENTRIES)) & (ENTRIES - 1); }
+
+  UINT32 get(UINT32 idx) const{ return hist[idx]; }
+  void set(UINT32 idx, UINT32 h){ hist[idx] = h; }
+
+  void push(UINT32 idx, bool taken){
+    hist[idx] = ((hist[idx] << 1) | (UINT32)taken) & (UINT32)((1ull << HIST_BITS) - 1);
+  }
+
+  void prefetch(UINT32 PC) const{ __builtin_prefetch(&hist[index(PC)]); }
+
+  void save(StateWriter &w) const{
+    for(UINT32 i = 0; i < ENTRIES; i++){
+      w.put(hist[i], HIST_BITS);
+    }
+  }
+
+  void load(StateReader &r){
+    for(UINT32 i = 0; i < ENTRIES; i++){
+      hist[i] = r.get(HIST_BITS);
+    }
+  }
+
+private:
+  UINT32 hist[ENTRIES];
+};
+
+// the low len bits of h folded to width bits
+inline UINT32 fold_bits(UINT32 h, int len, int width){
+  h &= (UINT32)((1ull << len) - 1);
+  UINT32 r = 0;
+  for(; h; h >>= width){
+    r ^= h & ((1u << width) - 1);
+  }
+  return r;
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef _LOOP_TABLE_H_
+#define _LOOP_TABLE_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+
+#define LOOP_TABLE_ENTRY_NUM 512
+#define LOOP_TABLE_INDEX_WIDTH 9
+#define LOOP_TAG_WIDTH 14
+#define LOOP_CONFIDENC_WIDTH 2
+#define LOOP_COUNT_WIDTH 14
+#define LOOP_AGE_WIDTH 8
+
+// the tag lives apart from the rest of the entry, in LoopTable::tag
+struct LoopTableEntry{
+  uint16_t past_iter_count; //14 bits
+  uint16_t now_iter_count;  // 14 bits
+  uint8_t confidenc_count;  // 2 bits
+  uint8_t age_count;        // 8 bits
+};
+
+
+// LOOP_TABLE_ENTRY_NUM entries in sets of WAYS, set selected by the low PC
+// bits and the entry within it by tag. The tags of a set are stored next to
+// each other, so with 4 ways one 64-bit load compares them all at once. On a
+// miss the way of the set with the lowest age is aged further, and replaced
+// once its age reaches 0. With WAYS = 1 this is the original direct-mapped table.
+template<int WAYS = 1>
+class LoopTable{
+  public:
+    static_assert(WAYS == 1 || WAYS == 2 || WAYS == 4, "WAYS must be 1, 2 or 4");
+    static const int SET_WIDTH = LOOP_TABLE_INDEX_WIDTH - (WAYS == 4 ? 2 : WAYS == 2 ? 1 : 0);
+
+    LoopTableEntry ltable[LOOP_TABLE_ENTRY_NUM];
+    uint16_t tag[LOOP_TABLE_ENTRY_NUM];  // 14 bits, set s in [s * WAYS, (s + 1) * WAYS)
+    bool use_loop;
+    bool loop_pred;
+    uint32_t loop_idx;  // entry that hit, or the first entry of the set on a miss
+    uint16_t loop_tag;
+
+    LoopTable() = default;
+
+    void init(){
+      for(int i = 0; i < LOOP_TABLE_ENTRY_NUM; i++){
+        ltable[i].past_iter_count = 0;
+        ltable[i].now_iter_count = 0;
+        tag[i] = 0;
+        ltable[i].confidenc_count = 0;
+        ltable[i].age_count = 0;
+      }
+      use_loop = false;
+      loop_pred = false;
+      loop_idx = 0;
+      loop_tag = 0;
+    }
+
+    // the entries only; use_loop, loop_pred, loop_idx and loop_tag live
+    // between one prediction and its update
+    void save(StateWriter &w) const{
+      for(int i = 0; i < LOOP_TABLE_ENTRY_NUM; i++){
+        w.put(ltable[i].past_iter_count, LOOP_COUNT_WIDTH);
+        w.put(ltable[i].now_iter_count, LOOP_COUNT_WIDTH);
+        w.put(tag[i], LOOP_TAG_WIDTH);
+        w.put(ltable[i].confidenc_count, LOOP_CONFIDENC_WIDTH);
+        w.put(ltable[i].age_count, LOOP_AGE_WIDTH);
+      }
+    }
+
+    void load(StateReader &r){
+      for(int i = 0; i < LOOP_TABLE_ENTRY_NUM; i++){
+        ltable[i].past_iter_count = r.get(LOOP_COUNT_WIDTH);
+        ltable[i].now_iter_count = r.get(LOOP_COUNT_WIDTH);
+        tag[i] = r.get(LOOP_TAG_WIDTH);
+        ltable[i].confidenc_count = r.get(LOOP_CONFIDENC_WIDTH);
+        ltable[i].age_count = r.get(LOOP_AGE_WIDTH);
+      }
+    }
+
+    void prefetch(UINT32 pc) const{
+      UINT32 first = (pc & ((1 << SET_WIDTH) - 1)) * WAYS;
+      __builtin_prefetch(&tag[first]);
+      __builtin_prefetch(&ltable[first]);
+    }
+
+    void get_loop_pred(UINT32 pc){
+      use_loop = false;
+      loop_pred = false;
+      loop_idx = (pc & ((1 << SET_WIDTH) - 1)) * WAYS;
+      loop_tag = (pc >> SET_WIDTH) & ((1 << LOOP_TAG_WIDTH) - 1);
+      int way = find_way(loop_idx, loop_tag);
+      if(way < 0) return;
+      loop_idx += way;
+      if(ltable[loop_idx].past_iter_count > ltable[loop_idx].now_iter_count){
+        loop_pred = TAKEN;
+      }
+      else if(ltable[loop_idx].past_iter_count == ltable[loop_idx].now_iter_count){
+        loop_pred = NOT_TAKEN;
+      }
+      if(ltable[loop_idx].confidenc_count == (1<<LOOP_CONFIDENC_WIDTH) - 1){
+        use_loop = true;
+      }
+      else{
+        use_loop = false;
+      }
+    }
+
+    void update_loop_pred(UINT32 pc, bool resolveDir, bool tage_pred){
+      // the tags are compared again: the entry may have been replaced
+      // since the prediction
+      UINT32 first = loop_idx - loop_idx % WAYS;
+      int way = find_way(first, loop_tag);
+      // tag not match
+      if(way < 0){
+        UINT32 victim = first + victim_way(first);
+        if(ltable[victim].age_count > 0){
+          ltable[victim].age_count = SatDecrement(ltable[victim].age_count);
+        }
+        // allocate new if age = 0
+        else{
+          tag[victim] = loop_tag;
+          ltable[victim].past_iter_count = (1 << LOOP_COUNT_WIDTH) - 1;
+          ltable[victim].now_iter_count = 0;
+          ltable[victim].confidenc_count = 0;
+          ltable[victim].age_count = (1 << LOOP_AGE_WIDTH) - 1;
+        }
+        return;
+      }
+      // tag match
+      UINT32 idx = first + way;
+      ltable[idx].now_iter_count++;
+      // prediction is correct
+      if(loop_pred == resolveDir){
+        if(resolveDir == NOT_TAKEN){
+          ltable[idx].now_iter_count = 0;
+          if(tage_pred != resolveDir){
+            ltable[idx].confidenc_count = SatIncrement(ltable[idx].confidenc_count, (1<<LOOP_CONFIDENC_WIDTH) - 1);
+            ltable[idx].age_count = SatIncrement(ltable[idx].age_count, (1 << LOOP_AGE_WIDTH) - 1);
+          }
+        }
+      }
+      // prediction is incorrect
+      else{
+        // new allocated entry
+        if(ltable[idx].age_count == (1 << LOOP_AGE_WIDTH) - 1 && ltable[idx].confidenc_count <= 1){
+          ltable[idx].past_iter_count = ltable[idx].now_iter_count;
+          ltable[idx].now_iter_count = 0;
+        }
+        else{
+          ltable[idx].now_iter_count = 0;
+          ltable[idx].age_count = 0;
+          ltable[idx].confidenc_count = 0;
+          ltable[idx].past_iter_count = 0;
+          tag[idx] = 0;
+        }
+      }
+    }
+
+  private:
+    // way of the set starting at first holding tag t, -1 if none
+    int find_way(UINT32 first, uint16_t t) const{
+      if(WAYS == 4){
+        // four 16-bit tags in one word: a lane is zero after the XOR exactly
+        // when its tag matches, and the lowest such lane is the way
+        const UINT64 LOW = 0x0001000100010001ull, HIGH = 0x8000800080008000ull;
+        UINT64 v;
+        memcpy(&v, &tag[first], sizeof(v));
+        UINT64 x = v ^ (LOW * t);
+        UINT64 zero = ~(((x & ~HIGH) + ~HIGH) | x) & HIGH;
+        return zero ? __builtin_ctzll(zero) / 16 : -1;
+      }
+      for(int w = 0; w < WAYS; w++){
+        if(tag[first + w] == t) return w;
+      }
+      return -1;
+    }
+
+    // the way with the lowest age, the first one on a tie
+    int victim_way(UINT32 first) const{
+      int best = 0;
+      for(int w = 1; w < WAYS; w++){
+        if(ltable[first + w].age_count < ltable[first + best].age_count) best = w;
+      }
+      return best;
+    }
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef _STAT_CORRECTOR_H_
+#define _STAT_CORRECTOR_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+
+// Statistical corrector in the style of TAGE-SC-L [4]: NUM_TABLES GEHL
+// tables of CTR_BITS signed counters, each indexed by the PC, TAGE's
+// prediction and one history signal (a folded global or local history of its
+// own length, or nothing for the bias table). The counters read for a branch are summed
+// together with a term for TAGE's own confidence; the sign of the sum is the
+// corrected prediction. Counters are trained on a misprediction or while the
+// sum is below a threshold, which itself adapts to keep those two events
+// about equally frequent (the O-GEHL dynamic threshold).
+//
+// All tables share one flat array, table t at t << LOG_SIZE, and the
+// counters read for one branch are gathered into a LANES wide vector padded
+// with zeros, so the adder tree is one fixed-length loop the compiler turns
+// into a few SIMD adds.
+template<int NUM_TABLES, int LOG_SIZE, int CTR_BITS>
+class StatCorrector{
+public:
+  static const UINT32 SIZE = 1u << LOG_SIZE;
+  static const int LANES = (NUM_TABLES + 7) & ~7;
+  static const int CTR_MAX = (1 << (CTR_BITS - 1)) - 1;
+  static const int CTR_MIN = -(1 << (CTR_BITS - 1));
+  static const int THETA_BITS = 8;
+  static const int TC_BITS = 7;
+  static const int TC_MAX = (1 << (TC_BITS - 1)) - 1;
+  static const int TC_MIN = -(1 << (TC_BITS - 1));
+  static_assert(CTR_BITS >= 2 && CTR_BITS <= 8, "counters are int8_t");
+
+  // what predict() leaves for update(); kept by the caller so outstanding
+  // predictions can each carry their own
+  struct Lookup{
+    UINT32 idx[NUM_TABLES];
+    int sum;
+    bool pred;
+  };
+
+  static UINT32 index(int t, UINT32 PC, UINT32 hist, bool tage_pred){
+    return ((PC ^ (PC >> (LOG_SIZE - t % LOG_SIZE)) ^ hist) << 1 | (UINT32)tage_pred) & (SIZE - 1);
+  }
+
+  void init(int theta_init){
+    memset(ctr, 0, sizeof(ctr));
+    theta = theta_init;
+    tc = 0;
+  }
+
+  // hist[t] is the history signal of table t, already folded to LOG_SIZE
+  // bits; tage_conf is TAGE's prediction as a centered counter value, its
+  // sign the direction and its magnitude the confidence
+  bool predict(Lookup &l, UINT32 PC, const UINT32 *hist, bool tage_pred, int tage_conf) const{
+    int16_t lane[LANES];
+#pragma GCC unroll 16
+    for(int t = 0; t < NUM_TABLES; t++){
+      l.idx[t] = index(t, PC, hist[t], tage_pred);
+      lane[t] = 2 * ctr[(t << LOG_SIZE) + l.idx[t]] + 1;
+    }
+    for(int t = NUM_TABLES; t < LANES; t++){
+      lane[t] = 0;
+    }
+    int sum = tage_conf;
+    for(int t = 0; t < LANES; t++){
+      sum += lane[t];
+    }
+    l.sum = sum;
+    l.pred = sum >= 0;
+    return l.pred;
+  }
+
+  void update(const Lookup &l, bool resolveDir){
+    int mag = l.sum < 0 ? -l.sum : l.sum;
+    if(l.pred != resolveDir){
+      if(++tc == TC_MAX){
+        theta = min(theta + 1, (1 << THETA_BITS) - 1);
+        tc = 0;
+      }
+    }
+    else if(mag < theta){
+      if(--tc == TC_MIN){
+        theta = max(theta - 1, 0);
+        tc = 0;
+      }
+    }
+    if(l.pred == resolveDir && mag >= theta) return;
+#pragma GCC unroll 16
+    for(int t = 0; t < NUM_TABLES; t++){
+      int8_t &c = ctr[(t << LOG_SIZE) + l.idx[t]];
+      if(resolveDir){
+        if(c < CTR_MAX) c++;
+      }
+      else if(c > CTR_MIN){
+        c--;
+      }
+    }
+  }
+
+  // the counters of both TAGE predictions share a line
+  void prefetch(UINT32 PC, const UINT32 *hist) const{
+    for(int t = 0; t < NUM_TABLES; t++){
+      __builtin_prefetch(&ctr[(t << LOG_SIZE) + index(t, PC, hist[t], false)]);
+    }
+  }
+
+  void save(StateWriter &w) const{
+    for(UINT32 i = 0; i < (UINT32)NUM_TABLES << LOG_SIZE; i++){
+      w.put((uint8_t)ctr[i], CTR_BITS);
+    }
+    w.put(theta, THETA_BITS);
+    w.put((UINT32)tc, TC_BITS);
+  }
+
+  void load(StateReader &r){
+    for(UINT32 i = 0; i < (UINT32)NUM_TABLES << LOG_SIZE; i++){
+      ctr[i] = (int8_t)(r.get(CTR_BITS) << (8 - CTR_BITS)) >> (8 - CTR_BITS); // sign extend
+    }
+    theta = r.get(THETA_BITS);
+    tc = (int)(r.get(TC_BITS) << (32 - TC_BITS)) >> (32 - TC_BITS);
+  }
+
+private:
+  int8_t ctr[NUM_TABLES << LOG_SIZE];
+  int theta;  // train while |sum| < theta
+  int tc;     // mispredictions minus low-margin correct predictions since theta last moved
+};
+
+#endif
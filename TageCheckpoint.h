@@ -0,0 +1,79 @@
+#ifndef _TAGE_CHECKPOINT_H_
+#define _TAGE_CHECKPOINT_H_
+
+#include "utils.h"
+
+// Bit-packed serialization of predictor state. Every field is written with
+// exactly the number of bits it has in hardware, least significant bit first,
+// so a checkpoint is about as large as the predictor's storage budget and does
+// not depend on the host's struct layout or byte order.
+
+#define TAGE_CKPT_MAGIC   0x504b4354u // "TCKP"
+#define TAGE_CKPT_VERSION 6
+
+// bits needed to hold every value in [0, max]
+constexpr int ckpt_bits(UINT64 max){
+  return max == 0 ? 0 : 1 + ckpt_bits(max >> 1);
+}
+
+class StateWriter{
+public:
+  explicit StateWriter(FILE *out): out(out), acc(0), acc_bits(0), ok(true){}
+
+  void put(UINT64 value, int bits){
+    for(int i = 0; i < bits; i++){
+      acc |= ((value >> i) & 1) << acc_bits;
+      if(++acc_bits == 8) flush_byte();
+    }
+  }
+
+  // pad to a byte boundary and report whether everything reached the file
+  bool finish(){
+    if(acc_bits) flush_byte();
+    return ok;
+  }
+
+private:
+  FILE *out;
+  UINT32 acc;
+  int acc_bits;
+  bool ok;
+
+  void flush_byte(){
+    ok = ok && fputc(acc, out) != EOF;
+    acc = 0;
+    acc_bits = 0;
+  }
+};
+
+class StateReader{
+public:
+  explicit StateReader(FILE *in): in(in), acc(0), acc_bits(0), ok(true){}
+
+  UINT64 get(int bits){
+    UINT64 value = 0;
+    for(int i = 0; i < bits; i++){
+      if(acc_bits == 0){
+        int c = fgetc(in);
+        ok = ok && c != EOF;
+        acc = c == EOF ? 0 : c;
+        acc_bits = 8;
+      }
+      value |= (UINT64)(acc & 1) << i;
+      acc >>= 1;
+      acc_bits--;
+    }
+    return value;
+  }
+
+  // false once a read ran past the end of the file
+  bool good() const{ return ok; }
+
+private:
+  FILE *in;
+  UINT32 acc;
+  int acc_bits;
+  bool ok;
+};
+
+#endif
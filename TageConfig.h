@@ -0,0 +1,137 @@
+#ifndef _TAGE_CONFIG_H_
+#define _TAGE_CONFIG_H_
+
+// Compile-time configurations for TageCore. TageBaseConfig holds the values
+// shared by the variants in this repo; each variant derives from it and
+// redefines what it changes (a redefined member hides the base one).
+struct TageBaseConfig{
+  static const int NUM_TABLES = 4;
+  static constexpr int HIST_LEN[NUM_TABLES] = {5, 14, 37, 100};   // each tagged table's history length, at most GHR_LEN
+  static constexpr int TAG_HIST_LEN[NUM_TABLES] = {9, 9, 9, 9};   // history bits hashed into each tag
+  static const int GHR_LEN = 700;            // global history register len
+
+  static const int BASE_INDEX_WIDTH = 13;
+  static const int BASE_CTR_INIT = 2;
+  static const int BASE_CTR_MAX = 3;
+
+  static const int INDEX_WIDTH = 12;         // each tagged table has 2^12 entry
+  static const int TAG_WIDTH = 9;
+  static const int U_WIDTH = 2;
+  static const int CTR_WIDTH = 3;
+  static const int TAGGED_CTR_INIT = 0;
+  static const int TAGGED_CTR_MAX = 7;
+  static const int TAGGED_WEAK_CORRECT = 4;
+
+  static const int USE_ALT_MAX = 15;
+  static const int USE_ALT_INIT = 4;
+  static const bool USE_ALT_ON_NEW_ENTRY = true;   // predict with altpred when the provider entry is new
+  static const bool USE_ALT_TRAIN_NEW_ONLY = true; // only train use_alt on new provider entries
+
+  static const int RNG_SEED = 3407;         // seed of the predictor's own random source (TageRandom.h)
+  static const bool RESEED_ON_ALLOC = false; // reseed it before every allocation draw
+
+  static const int U_RESET_PERIOD_LOG = 18;  // reset one u bit every 2^18 branches
+  static const int U_RESET_SLICE = 0;        // entries aged per update, 0 ages every tagged table at once
+
+  static const bool USE_LOOP = true;         // loop table
+  static const int LOOP_WAYS = 1;            // loop table associativity: 1 (direct mapped), 2 or 4
+  static const bool USE_CF = true;           // corrector filter
+
+  // statistical corrector (StatCorrector.h); takes the corrector filter's
+  // place, so a config sets at most one of USE_CF and USE_SC
+  static const bool USE_SC = false;
+  static const int SC_NUM_TABLES = 6;
+  static constexpr int SC_HIST_LEN[SC_NUM_TABLES] = {0, 2, 5, 9, 16, 27}; // 0 = bias table, PC and TAGE only
+  static const int SC_LOG_SIZE = 10;         // 2^10 counters per table
+  static const int SC_CTR_BITS = 6;
+  static const int SC_THETA_INIT = 12;
+  static const int SC_TAGE_WEIGHT = 4;       // TAGE's centered provider counter is added with this weight
+
+  // per-branch local history (LocalHistory.h), feeding SC_NUM_LOCAL_TABLES
+  // more SC tables when USE_SC is set and the first LOCAL_TAGE_TABLES tagged
+  // tables, which then hash the local history of their HIST_LEN and
+  // TAG_HIST_LEN instead of the global one (both at most LOCAL_HIST_BITS)
+  static const bool USE_LOCAL = false;
+  static const int LOCAL_LOG_ENTRIES = 10;   // 2^10 history registers
+  static const int LOCAL_HIST_BITS = 16;
+  static const int LOCAL_TAGE_TABLES = 0;
+  static const int SC_NUM_LOCAL_TABLES = 3;
+  static constexpr int SC_LOCAL_HIST_LEN[SC_NUM_LOCAL_TABLES] = {3, 6, 11};
+
+  static const int PATH_HIST_LEN = 0;        // path history bits hashed into index and tag, 0 = none
+  static const int PATH_BITS = 2;            // address bits each branch shifts into the path history
+
+  // branches whose history, indices and prefetches PredictBlock runs ahead
+  // of the tables; 0 turns this off, which is faster while the tagged tables
+  // stay cache resident, as all of the configurations below do
+  static const int BATCH_LOOKAHEAD = 0;
+
+  static const int SPEC_MAX_INFLIGHT = 128;  // predictions the speculative and delayed-update modes may have outstanding
+};
+
+// TagePredictor: base TAGE
+struct TageConfig : TageBaseConfig{
+  static const int BASE_INDEX_WIDTH = 14;
+  static constexpr int TAG_HIST_LEN[NUM_TABLES] = {5, 9, 9, 9};
+  static const bool USE_ALT_ON_NEW_ENTRY = false;
+  static const bool USE_ALT_TRAIN_NEW_ONLY = false;
+  static const bool RESEED_ON_ALLOC = true;
+  static const bool USE_LOOP = false;
+  static const bool USE_CF = false;
+};
+
+// TagePredictorOpt: altpred for new entries
+struct TageOptConfig : TageConfig{
+  static const int USE_ALT_INIT = 7;
+  static const bool USE_ALT_ON_NEW_ENTRY = true;
+};
+
+// TagePredictor8Com: 8 tagged tables
+struct Tage8ComConfig : TageOptConfig{
+  static const int NUM_TABLES = 8;
+  static constexpr int HIST_LEN[NUM_TABLES] = {5, 8, 12, 18, 28, 42, 65, 100};
+  static constexpr int TAG_HIST_LEN[NUM_TABLES] = {5, 8, 11, 11, 11, 11, 11, 11};
+  static const int INDEX_WIDTH = 11;
+  static const int TAG_WIDTH = 11;
+};
+
+// LTAGEPredictor: TAGE with loop table
+struct LTageConfig : TageBaseConfig{
+  static const int USE_ALT_INIT = 8;
+  static const bool USE_ALT_TRAIN_NEW_ONLY = false;
+  static const bool RESEED_ON_ALLOC = true;
+  static const bool USE_CF = false;
+};
+
+// TAGE_SC_LPredictor: TAGE with loop table and corrector filter
+struct TageSCLConfig : TageBaseConfig{
+  static const int USE_ALT_INIT = 8;
+  static const bool USE_ALT_TRAIN_NEW_ONLY = false;
+};
+
+// predictor: tuned TAGE_SC_L, use_alt only trained on new entries
+struct PredictorConfig : TageBaseConfig{
+};
+
+// predictor with path history: the last 8 branches, conditional or not,
+// hashed into index and tag
+struct PredictorPathConfig : PredictorConfig{
+  static const int PATH_HIST_LEN = 16;
+};
+
+// predictor with the statistical corrector in place of the corrector filter
+// and a 4-way loop table
+struct PredictorSCConfig : PredictorConfig{
+  static const bool USE_CF = false;
+  static const bool USE_SC = true;
+  static const int LOOP_WAYS = 4;
+};
+
+// predictor_sc with local history in the statistical corrector and in the
+// first tagged table (HIST_LEN 5, TAG_HIST_LEN 9)
+struct PredictorLocalConfig : PredictorSCConfig{
+  static const bool USE_LOCAL = true;
+  static const int LOCAL_TAGE_TABLES = 1;
+};
+
+#endif
@@ -0,0 +1,1021 @@
+#ifndef _TAGE_CORE_H_
+#define _TAGE_CORE_H_
+
+#include "utils.h"
+#include "tracer.h"
+#include "TageHistory.h"
+#include "TageTable.h"
+#include "TageStats.h"
+#include "TageCheckpoint.h"
+#include "LoopTable.h"
+#include "CorrectorFilter.h"
+#include "StatCorrector.h"
+#include "LocalHistory.h"
+#include "TageRandom.h"
+#include <type_traits>
+
+// TAGE predictor with optional loop table, local history and corrector
+// filter or statistical corrector, parameterized
+// by a config from TageConfig.h. Every TAGE variant in this repo is an
+// instantiation: with the table count, widths and history lengths known at
+// compile time the loops over components unroll and the masks fold, and any
+// number of configurations can live in one binary. All state is held inline,
+// without pointers, so a copy of a TageCore is an independent predictor in
+// the same state: forking a warmed predictor is a single memcpy.
+template<class Config>
+class TageCore{
+public:
+  static const int NUM_TABLES = Config::NUM_TABLES;
+  static const int INDEX_WIDTH = Config::INDEX_WIDTH;
+  static const int TAG_WIDTH = Config::TAG_WIDTH;
+  static const UINT32 BASE_TABLE_SIZE = 1u << Config::BASE_INDEX_WIDTH;
+  static const int SC_NUM_TABLES = Config::SC_NUM_TABLES; // global history SC tables
+  static const int SC_LOCAL_TABLES = Config::USE_LOCAL ? Config::SC_NUM_LOCAL_TABLES : 0;
+  static const int SC_TABLES = SC_NUM_TABLES + SC_LOCAL_TABLES;
+  typedef StatCorrector<SC_TABLES, Config::SC_LOG_SIZE, Config::SC_CTR_BITS> SC;
+  typedef PackedTageTable<NUM_TABLES, INDEX_WIDTH, TAG_WIDTH, Config::U_WIDTH, Config::CTR_WIDTH> TagTable;
+  static const int LANES = TagTable::Lanes::LANES; // tag and index arrays padded to whole vectors
+
+  // The interface to the four functions below CAN NOT be changed
+
+  TageCore(void);
+  bool    GetPrediction(UINT32 PC);
+  void    UpdatePredictor(UINT32 PC, bool resolveDir, bool predDir, UINT32 branchTarget);
+  void    TrackOtherInst(UINT32 PC, OpType opType, UINT32 branchTarget);
+
+  // Replay n trace records in one call: each conditional branch is predicted
+  // and then updated with its outcome, everything else goes to
+  // TrackOtherInst. Same result as calling those one by one, but the
+  // history is advanced BATCH_LOOKAHEAD branches at a time ahead of the
+  // tables and their rows are prefetched. Returns the mispredictions.
+  // Record is any type with PC, branchTarget, opType and taken fields (the
+  // replay driver's TraceRecord), so this header still builds against the
+  // cbp4 tracer.h.
+  template<class Record>
+  UINT64 PredictBlock(const Record *recs, size_t n);
+
+  // Speculative mode, for modelling a front end that predicts ahead of
+  // resolution. PredictSpeculative predicts PC from the current, possibly
+  // speculative history, remembers everything the later update needs, and
+  // shifts the predicted direction into the history. ResolveSpeculative
+  // trains the tables for the oldest outstanding prediction with its actual
+  // outcome; on a misprediction it repairs the history to that branch, drops
+  // every younger prediction (they must be predicted again) and returns
+  // true. At most SPEC_MAX_INFLIGHT predictions may be outstanding, and the
+  // plain interface must not be used while any are.
+  bool PredictSpeculative(UINT32 PC);
+  bool ResolveSpeculative(bool resolveDir, UINT32 branchTarget);
+  int MaxInFlight() const { return Config::SPEC_MAX_INFLIGHT; }
+
+  // Delayed-update mode: the history takes the real outcome right away, but
+  // the tables are only trained when UpdateDeferred is called with the
+  // returned handle, in whatever order the caller likes, so predictions made
+  // in between read stale tables. Shares the SPEC_MAX_INFLIGHT slots with
+  // the speculative mode; -1 when they are all in use.
+  int PredictDeferred(UINT32 PC, bool resolveDir, bool *predDir);
+  void UpdateDeferred(int handle, bool resolveDir);
+
+  int GetProvider() const { return provider_component; }
+  // restart the random source used by allocation and the corrector filter
+  // from seed instead of Config::RNG_SEED
+  void SetSeed(UINT32 seed);
+  // replace the index history lengths of the tagged tables (n must be
+  // NUM_TABLES, each length in [1, GHR_LEN]); valid at any point, the folded
+  // registers are rebuilt from the current history
+  bool SetHistoryLengths(const int *lens, int n);
+  void DumpStats(FILE *out);
+  // Write/restore the complete predictor state between two branches: a
+  // versioned header, the config it was built with and every table and
+  // history register, bit-packed (see TageCheckpoint.h). LoadState fails on a
+  // checkpoint of another version or config; the predictor must not be used
+  // after a failed load. Statistics are not part of the state.
+  bool SaveState(FILE *out) const;
+  bool LoadState(FILE *in);
+
+protected:
+  GlobalHistory<Config::GHR_LEN, Config::SPEC_MAX_INFLIGHT> ghr; // global history register
+  uint8_t  base_table[BASE_TABLE_SIZE]; // base prediction table
+  TagTable tag_table;
+  int hist_len[NUM_TABLES];           // index history length of each table
+  FoldedHistoryBank<NUM_TABLES, LANES> idx_fold; // history folded to index width
+  FoldedHistoryBank<NUM_TABLES, LANES> tag_fold; // history folded to tag width
+  UINT32 phist;                       // path history, PATH_BITS per branch, newest in the low bits
+
+  UINT32 tag[LANES];
+  UINT32 tag_table_idx[LANES];
+  UINT32 sc_hist[SC_TABLES];
+  int simd;              // TageSimdLevel of the lookup kernels, detected at construction
+  UINT32 clock;
+  uint8_t u_reset_mask;  // u bits kept by the reset in progress
+  UINT32 u_reset_pos;    // next entry to age, tag_table.size() when idle
+  int provider_component;
+  int altpred_component;
+  bool pred;
+  bool altpred;
+
+  bool tage_pred;
+  bool cf_pred;
+  bool high_conf;
+  uint16_t use_cf;
+  uint16_t use_alt;
+  bool pred_is_new_entry;
+
+  TageRandom rng;
+  UINT32 rng_seed;
+  UINT32 reseed_draw;    // first draw after seeding, which every RESEED_ON_ALLOC draw is
+  LoopTable<Config::LOOP_WAYS> ltable;
+  CorrectorFilter correct_filter;
+  SC sc;
+  FoldedHistory sc_fold[SC_NUM_TABLES]; // history of each SC table folded to its index width
+  typename SC::Lookup sc_lookup;
+  LocalHistoryTable<Config::LOCAL_LOG_ENTRIES, Config::LOCAL_HIST_BITS> lhist;
+  UINT32 local_hist;                    // local history of the branch being predicted
+#ifdef TAGE_STATS
+  TageStats<NUM_TABLES> stats;
+#endif
+
+  // an outstanding prediction: the history as it was before the prediction
+  // was shifted in, and the per-prediction state that GetPrediction leaves
+  // for UpdatePredictor
+  struct SpecSlot{
+    UINT32 PC;
+    bool pred_dir;
+    int ghr_head;
+    UINT32 phist;
+    UINT32 idx_comp[NUM_TABLES];
+    UINT32 tag_comp[NUM_TABLES];
+    UINT32 sc_comp[SC_NUM_TABLES];
+    UINT32 tag[NUM_TABLES];
+    UINT32 tag_table_idx[NUM_TABLES];
+    int provider_component;
+    int altpred_component;
+    bool pred;
+    bool altpred;
+    bool tage_pred;
+    bool cf_pred;
+    bool high_conf;
+    bool pred_is_new_entry;
+    bool use_loop;
+    bool loop_pred;
+    uint32_t loop_idx;
+    uint16_t loop_tag;
+    typename SC::Lookup sc_lookup;
+    UINT32 local_hist; // before this prediction was shifted in
+  };
+  SpecSlot spec_slots[Config::SPEC_MAX_INFLIGHT];
+  int spec_free[Config::SPEC_MAX_INFLIGHT]; // stack of unused slots
+  int spec_num_free;
+  int spec_fifo[Config::SPEC_MAX_INFLIGHT]; // speculative predictions, oldest first
+  int spec_oldest;
+  int spec_count;
+
+  int save_slot(UINT32 PC, bool dir);
+  void restore_slot(const SpecSlot &s);
+
+  void hash_tables(UINT32 PC, UINT32 *idx, UINT32 *tag);
+  bool lookup(UINT32 PC);
+  // prediction of tagged table c, or base_pred for c == -1
+  bool component_pred(int c, bool base_pred) const{
+    int t = max(c, 0);
+    bool tagged = tag_table.ctr(t, tag_table_idx[t]) > Config::TAGGED_CTR_MAX / 2;
+    return c >= 0 ? tagged : base_pred;
+  }
+  void prefetch_untagged(UINT32 PC, const UINT32 *sc_hist) const;
+  void train(UINT32 PC, bool resolveDir, bool predDir);
+  uint16_t get_tag(UINT32 PC, int bank_idx);
+  UINT32 get_tagged_idx(UINT32 PC, int bank_idx);
+  UINT32 path_hash(int bank_idx, int width) const;
+  void get_sc_hist(UINT32 *out) const;
+  int tage_confidence(uint8_t base_counter) const;
+  void update_history(UINT32 PC, bool resolveDir);
+  void update_path(UINT32 bits);
+  static int config_words(UINT32 *words);
+  static constexpr bool local_lens_fit(){
+    for(int i = 0; i < Config::LOCAL_TAGE_TABLES; i++){
+      if(Config::HIST_LEN[i] > Config::LOCAL_HIST_BITS || Config::TAG_HIST_LEN[i] > Config::LOCAL_HIST_BITS) return false;
+    }
+    for(int j = 0; j < SC_LOCAL_TABLES; j++){
+      if(Config::SC_LOCAL_HIST_LEN[j] > Config::LOCAL_HIST_BITS) return false;
+    }
+    return Config::LOCAL_TAGE_TABLES == 0 || Config::USE_LOCAL;
+  }
+
+  static const int CLOCK_BITS = Config::U_RESET_PERIOD_LOG + 1;
+  static const int CONFIG_WORDS_MAX = 32 + 2 * NUM_TABLES + SC_TABLES;
+};
+
+/////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////
+
+template<class Config>
+TageCore<Config>::TageCore(void){
+  static_assert(Config::HIST_LEN[NUM_TABLES - 1] <= Config::GHR_LEN, "history longer than GHR_LEN");
+  static_assert(Config::PATH_HIST_LEN <= 32 && INDEX_WIDTH >= 8 && TAG_WIDTH >= 8, "path history does not fold");
+  static_assert(!(Config::USE_CF && Config::USE_SC), "one corrector at most");
+  static_assert(std::is_trivially_copyable<TageCore>::value, "state must copy as one flat block");
+  static_assert(local_lens_fit(), "local history longer than LOCAL_HIST_BITS");
+  SetSeed(Config::RNG_SEED);
+  simd = tage_simd_level();
+  ghr.init();
+
+  for(UINT32 ii=0; ii < BASE_TABLE_SIZE; ii++){
+    base_table[ii] = Config::BASE_CTR_INIT;
+  }
+
+  idx_fold.clear();
+  tag_fold.clear();
+  for (int j = 0; j < NUM_TABLES; j++){
+    hist_len[j] = Config::HIST_LEN[j];
+    idx_fold.init(j, hist_len[j], INDEX_WIDTH);
+    tag_fold.init(j, Config::TAG_HIST_LEN[j], TAG_WIDTH);
+  }
+  tag_table.init(Config::TAGGED_CTR_INIT);
+  phist = 0;
+
+  clock = 0;
+  u_reset_mask = 0;
+  u_reset_pos = tag_table.size();
+
+  use_alt = Config::USE_ALT_INIT;
+  pred_is_new_entry = false;
+
+  use_cf = 8;
+
+  for(int i = 0; i < Config::SPEC_MAX_INFLIGHT; i++){
+    spec_free[i] = Config::SPEC_MAX_INFLIGHT - 1 - i;
+  }
+  spec_num_free = Config::SPEC_MAX_INFLIGHT;
+  spec_oldest = 0;
+  spec_count = 0;
+
+  ltable.init();
+  correct_filter.init();
+  sc.init(Config::SC_THETA_INIT);
+  for(int j = 0; j < SC_NUM_TABLES; j++){
+    sc_fold[j].init(Config::SC_HIST_LEN[j], Config::SC_LOG_SIZE);
+  }
+  lhist.init();
+  local_hist = 0;
+#ifdef TAGE_STATS
+  stats.init();
+#endif
+}
+
+/////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////
+
+template<class Config>
+bool   TageCore<Config>::GetPrediction(UINT32 PC){
+  if(Config::USE_LOCAL){
+    local_hist = lhist.get(lhist.index(PC));
+  }
+  hash_tables(PC, tag_table_idx, tag);
+  get_sc_hist(sc_hist);
+  return lookup(PC);
+}
+
+// Index and tag of PC in every tagged table. Without path history or local
+// tables they depend on nothing but the folded registers and are computed
+// in vector lanes; otherwise one table at a time.
+template<class Config>
+void TageCore<Config>::hash_tables(UINT32 PC, UINT32 *idx, UINT32 *tag){
+  if(Config::PATH_HIST_LEN == 0 && Config::LOCAL_TAGE_TABLES == 0){
+    TagTable::Lanes::hash(simd, PC, idx_fold.comp, tag_fold.comp, idx, tag);
+    return;
+  }
+#pragma GCC unroll 16
+  for(int i = 0; i < NUM_TABLES; i++){
+    tag[i] = get_tag(PC, i);
+    idx[i] = get_tagged_idx(PC, i);
+  }
+}
+
+// the prediction proper, from the tags and indices already in tag[],
+// tag_table_idx[] and sc_hist[]
+template<class Config>
+bool   TageCore<Config>::lookup(UINT32 PC){
+  UINT32 base_index   = PC & (BASE_TABLE_SIZE - 1);
+  uint8_t base_counter = base_table[base_index];
+  bool base_pred = base_counter > Config::BASE_CTR_MAX/2;
+
+  if(Config::USE_LOOP){
+    ltable.get_loop_pred(PC);
+  }
+
+  // The provider is the longest hitting table and altpred the next longest,
+  // the base table when there is none. With the base table as bit 0 below
+  // the hit mask both are found by counting leading zeros, without a branch
+  // on any hit, which replay of hard traces would mispredict.
+  UINT32 hits = tag_table.hit_mask(simd, tag_table_idx, tag);
+#ifdef TAGE_STATS
+  for(int i = 0; i < NUM_TABLES; i++){
+    stats.hits[i] += hits >> i & 1;
+  }
+#endif
+  UINT32 m = hits << 1 | 1;
+  int provider_bit = 31 - __builtin_clz(m);
+  int altpred_bit = 31 - __builtin_clz((m & ~(1u << provider_bit)) | 1);
+  provider_component = provider_bit - 1;
+  altpred_component = altpred_bit - 1;
+  pred = component_pred(provider_component, base_pred);
+  altpred = component_pred(altpred_component, base_pred);
+
+  // entries of the base table's slot (-1) are read from table 0 and ignored
+  int p = max(provider_component, 0);
+  UINT32 p_ctr = tag_table.ctr(p, tag_table_idx[p]);
+  pred_is_new_entry = (provider_component != -1) & (tag_table.u(p, tag_table_idx[p]) == 0) &
+                      ((p_ctr == Config::TAGGED_CTR_MAX / 2) | (p_ctr == Config::TAGGED_CTR_MAX / 2 + 1));
+
+  tage_pred = (Config::USE_ALT_ON_NEW_ENTRY && pred_is_new_entry && use_alt > Config::USE_ALT_MAX / 2 + 1) ? altpred : pred;
+
+  if(Config::USE_CF){
+    high_conf = false;
+    if(provider_component == -1){
+      high_conf = (base_counter == 0 || base_counter == Config::BASE_CTR_MAX);
+    }
+    else{
+      uint8_t temp_ctr = tag_table.ctr(provider_component, tag_table_idx[provider_component]);
+      high_conf = (temp_ctr >= 5) || (temp_ctr <= 2);
+    }
+    cf_pred = correct_filter.cf_predictor(PC, tage_pred, high_conf);
+  }
+  if(Config::USE_SC){
+    cf_pred = sc.predict(sc_lookup, PC, sc_hist, tage_pred, tage_confidence(base_counter));
+  }
+
+  if(Config::USE_LOOP && ltable.use_loop){
+    return ltable.loop_pred;
+  }
+  if(Config::USE_SC || (Config::USE_CF && use_cf > 7))
+    return cf_pred;
+  else
+    return tage_pred;
+}
+
+/////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////
+
+template<class Config>
+void  TageCore<Config>::UpdatePredictor(UINT32 PC, bool resolveDir, bool predDir, UINT32 branchTarget){
+  train(PC, resolveDir, predDir);
+  update_history(PC, resolveDir);
+}
+
+// everything UpdatePredictor does except shifting the history
+template<class Config>
+void  TageCore<Config>::train(UINT32 PC, bool resolveDir, bool predDir){
+
+  UINT32 base_index   = PC & (BASE_TABLE_SIZE - 1);
+  uint8_t base_counter = base_table[base_index];
+
+#ifdef TAGE_STATS
+  stats.branches++;
+  stats.mispredictions += predDir != resolveDir;
+  stats.provider[provider_component + 1]++;
+  stats.provider_mispred[provider_component + 1] += pred != resolveDir;
+  if(Config::USE_ALT_ON_NEW_ENTRY && provider_component != -1 && pred_is_new_entry &&
+     use_alt > Config::USE_ALT_MAX / 2 + 1){
+    stats.alt_override[provider_component]++;
+    stats.alt_override_correct[provider_component] += altpred == resolveDir;
+  }
+  if(Config::USE_LOOP && ltable.use_loop){
+    stats.loop_override++;
+    stats.loop_override_correct += ltable.loop_pred == resolveDir;
+  }
+  else if((Config::USE_SC || (Config::USE_CF && use_cf > 7)) && cf_pred != tage_pred){
+    stats.cf_flip++;
+    stats.cf_flip_correct += cf_pred == resolveDir;
+  }
+#endif
+
+  if(Config::USE_LOOP){
+    ltable.update_loop_pred(PC, resolveDir, use_alt?altpred:pred);
+  }
+
+  // update counter of provider component
+  if(provider_component == -1){
+      if(resolveDir == TAKEN){
+        base_table[base_index] = SatIncrement(base_counter, Config::BASE_CTR_MAX);
+      }else{
+        base_table[base_index] = SatDecrement(base_counter);
+      }
+  }
+  else{
+    uint8_t pred_ctr = tag_table.ctr(provider_component, tag_table_idx[provider_component]);
+    if(resolveDir == TAKEN){
+      tag_table.set_ctr(provider_component, tag_table_idx[provider_component], SatIncrement(pred_ctr, Config::TAGGED_CTR_MAX));
+    }
+    else{
+      tag_table.set_ctr(provider_component, tag_table_idx[provider_component], SatDecrement(pred_ctr));
+    }
+  }
+
+  // if prediction is incorrect, allocate entry
+  // don't need to allocate entry when altpred is false and pred is right, the u tag will do it(otherwise, we will always get the new entry?)
+  if(resolveDir != pred && provider_component != NUM_TABLES - 1){
+    // candidates are the tables above the provider whose entry has u == 0,
+    // as a mask built without branching on any u
+    UINT32 unalloc = 0;
+#pragma GCC unroll 16
+    for(int i = 0; i < NUM_TABLES; i++){
+      unalloc |= (UINT32)(tag_table.u(i, tag_table_idx[i]) == 0) << i;
+    }
+    unalloc &= ~0u << (provider_component + 1);
+    int count = __builtin_popcount(unalloc);
+    // if uk > 0 for k in (i, M), then uk = uk-1 for all uk
+    if(count == 0){
+#ifdef TAGE_STATS
+      stats.alloc_fail++;
+#endif
+      for(int i = provider_component + 1; i < NUM_TABLES; i++){
+#ifdef TAGE_STATS
+        stats.u_decrement[i] += tag_table.u(i, tag_table_idx[i]) > 0;
+#endif
+        tag_table.set_u(i, tag_table_idx[i], SatDecrement(tag_table.u(i, tag_table_idx[i])));
+      }
+    }
+    else{
+      // allocate one entry each time
+      // if more than one T_i need allocate, for i < j, the probility of allocate entry in T_i = 2 * T_j
+      // example:count = 3, rand = {0} for unalloc[2], rand = {1, 2} for unalloc[1], rand = {3,4,5,6} for unalloc[0]
+      // r in [2^i - 1, 2^(i+1) - 1) picks the i-th candidate from the top,
+      // i.e. the (count - 1 - i)-th set bit of unalloc from the bottom
+      int total_pro = (1 << count) - 1;
+      int r = (Config::RESEED_ON_ALLOC ? reseed_draw : rng.next()) % total_pro;
+      int skip = count - 1 - (31 - __builtin_clz(r + 1));
+#pragma GCC unroll 16
+      for(int i = 0; i < NUM_TABLES - 1; i++){
+        unalloc = i < skip ? unalloc & (unalloc - 1) : unalloc;
+      }
+      int choose_idx = __builtin_ctz(unalloc);
+      UINT32 idx_in_tag_table_choose = tag_table_idx[choose_idx];
+#ifdef TAGE_STATS
+      stats.alloc[choose_idx]++;
+#endif
+      if(resolveDir)
+        tag_table.set(choose_idx, idx_in_tag_table_choose, tag[choose_idx], 0, Config::TAGGED_WEAK_CORRECT);
+      else
+        tag_table.set(choose_idx, idx_in_tag_table_choose, tag[choose_idx], 0, Config::TAGGED_WEAK_CORRECT - 1);
+    }
+  }
+
+  // update use_alt
+  if(altpred != pred && provider_component != -1 && (pred_is_new_entry || !Config::USE_ALT_TRAIN_NEW_ONLY)){
+    if(pred != resolveDir){
+      use_alt = SatIncrement(use_alt, Config::USE_ALT_MAX);
+    }
+    else{
+      use_alt = SatDecrement(use_alt);
+    }
+  }
+
+  // update u
+  if(altpred != pred && provider_component != -1){
+    uint8_t u = tag_table.u(provider_component, tag_table_idx[provider_component]);
+    if(pred == resolveDir){
+      tag_table.set_u(provider_component, tag_table_idx[provider_component], SatIncrement(u, (1 << Config::U_WIDTH) - 1));
+    }
+    else{
+#ifdef TAGE_STATS
+      stats.u_decrement[provider_component] += u > 0;
+#endif
+      tag_table.set_u(provider_component, tag_table_idx[provider_component], SatDecrement(u));
+    }
+  }
+
+  // After 256k branch, reset u
+  clock ++;
+  uint8_t mask = 0;
+  if(clock == 1 << Config::U_RESET_PERIOD_LOG){
+    mask = 1;
+  }
+  else if(clock == 1 << (Config::U_RESET_PERIOD_LOG + 1)){
+    mask = 2;
+    clock = 0;
+  }
+  if(Config::U_RESET_SLICE){
+    // age U_RESET_SLICE entries per update instead of stalling this one branch
+    // on the whole sweep; a slice finishes long before the next reset is due
+    if(mask){
+      u_reset_mask = mask;
+      u_reset_pos = 0;
+    }
+    if(u_reset_pos < tag_table.size()){
+      UINT32 end = min(u_reset_pos + Config::U_RESET_SLICE, tag_table.size());
+      tag_table.reset_u(u_reset_mask, u_reset_pos, end);
+      u_reset_pos = end;
+    }
+  }
+  else if(mask){
+    tag_table.reset_u(mask);
+  }
+
+  // update correct filter
+  if(Config::USE_CF){
+    correct_filter.cf_update(PC, tage_pred, resolveDir, high_conf, rng);
+    if(tage_pred != cf_pred){
+      if(cf_pred == resolveDir){
+        use_cf = SatIncrement(use_cf, 15);
+      }
+      else{
+        use_cf = SatDecrement(use_cf);
+      }
+    }
+  }
+  if(Config::USE_SC){
+    sc.update(sc_lookup, resolveDir);
+  }
+}
+
+// the history signal of each SC table for the branch about to be predicted
+template<class Config>
+void TageCore<Config>::get_sc_hist(UINT32 *out) const{
+  if(!Config::USE_SC) return;
+#pragma GCC unroll 16
+  for(int j = 0; j < SC_NUM_TABLES; j++){
+    out[j] = sc_fold[j].comp;
+  }
+  for(int j = 0; j < SC_LOCAL_TABLES; j++){
+    out[SC_NUM_TABLES + j] = fold_bits(local_hist, Config::SC_LOCAL_HIST_LEN[j], Config::SC_LOG_SIZE);
+  }
+}
+
+// TAGE's prediction as a signed vote for the statistical corrector: the
+// provider's counter centered on zero (the base counter scaled to the same
+// range), pointing the way TAGE predicted and weighted by SC_TAGE_WEIGHT
+template<class Config>
+int TageCore<Config>::tage_confidence(uint8_t base_counter) const{
+  int c;
+  if(provider_component == -1){
+    c = (2 * base_counter - Config::BASE_CTR_MAX) * Config::TAGGED_CTR_MAX / Config::BASE_CTR_MAX;
+  }
+  else{
+    c = 2 * tag_table.ctr(provider_component, tag_table_idx[provider_component]) - Config::TAGGED_CTR_MAX;
+  }
+  if(c < 0) c = -c;
+  return (tage_pred ? c : -c) * Config::SC_TAGE_WEIGHT;
+}
+
+// take a free slot and fill it from the prediction GetPrediction just made
+template<class Config>
+int TageCore<Config>::save_slot(UINT32 PC, bool dir){
+  assert(spec_num_free > 0);
+  int h = spec_free[--spec_num_free];
+  SpecSlot &s = spec_slots[h];
+  s.PC = PC;
+  s.pred_dir = dir;
+  s.ghr_head = ghr.head();
+  s.phist = phist;
+  for(int i = 0; i < NUM_TABLES; i++){
+    s.idx_comp[i] = idx_fold.comp[i];
+    s.tag_comp[i] = tag_fold.comp[i];
+    s.tag[i] = tag[i];
+    s.tag_table_idx[i] = tag_table_idx[i];
+  }
+  for(int j = 0; j < SC_NUM_TABLES; j++){
+    s.sc_comp[j] = sc_fold[j].comp;
+  }
+  s.local_hist = local_hist;
+  s.provider_component = provider_component;
+  s.altpred_component = altpred_component;
+  s.pred = pred;
+  s.altpred = altpred;
+  s.tage_pred = tage_pred;
+  s.cf_pred = cf_pred;
+  s.high_conf = high_conf;
+  s.pred_is_new_entry = pred_is_new_entry;
+  s.use_loop = ltable.use_loop;
+  s.loop_pred = ltable.loop_pred;
+  s.loop_idx = ltable.loop_idx;
+  s.loop_tag = ltable.loop_tag;
+  s.sc_lookup = sc_lookup;
+  return h;
+}
+
+// put back the state train() expects from the prediction in s
+template<class Config>
+void TageCore<Config>::restore_slot(const SpecSlot &s){
+  for(int i = 0; i < NUM_TABLES; i++){
+    tag[i] = s.tag[i];
+    tag_table_idx[i] = s.tag_table_idx[i];
+  }
+  provider_component = s.provider_component;
+  altpred_component = s.altpred_component;
+  pred = s.pred;
+  altpred = s.altpred;
+  tage_pred = s.tage_pred;
+  cf_pred = s.cf_pred;
+  high_conf = s.high_conf;
+  pred_is_new_entry = s.pred_is_new_entry;
+  ltable.use_loop = s.use_loop;
+  ltable.loop_pred = s.loop_pred;
+  ltable.loop_idx = s.loop_idx;
+  ltable.loop_tag = s.loop_tag;
+  sc_lookup = s.sc_lookup;
+}
+
+template<class Config>
+bool TageCore<Config>::PredictSpeculative(UINT32 PC){
+  bool dir = GetPrediction(PC);
+  spec_fifo[(spec_oldest + spec_count) % Config::SPEC_MAX_INFLIGHT] = save_slot(PC, dir);
+  spec_count++;
+  update_history(PC, dir);
+  return dir;
+}
+
+template<class Config>
+bool TageCore<Config>::ResolveSpeculative(bool resolveDir, UINT32 branchTarget){
+  assert(spec_count > 0);
+  int h = spec_fifo[spec_oldest];
+  const SpecSlot &s = spec_slots[h];
+  restore_slot(s);
+  train(s.PC, resolveDir, s.pred_dir);
+
+  if(s.pred_dir == resolveDir){
+    spec_free[spec_num_free++] = h;
+    spec_oldest = (spec_oldest + 1) % Config::SPEC_MAX_INFLIGHT;
+    spec_count--;
+    return false;
+  }
+  // wrong path from here on: back to the history this branch saw, then the
+  // real outcome
+  ghr.rewind(s.ghr_head);
+  for(int i = 0; i < NUM_TABLES; i++){
+    idx_fold.comp[i] = s.idx_comp[i];
+    tag_fold.comp[i] = s.tag_comp[i];
+  }
+  for(int j = 0; j < SC_NUM_TABLES; j++){
+    sc_fold[j].comp = s.sc_comp[j];
+  }
+  phist = s.phist;
+  if(Config::USE_LOCAL){
+    // each younger prediction shifted into one local register; undo them
+    // newest first, so a register shared by several ends up as s found it
+    for(int i = spec_count - 1; i >= 0; i--){
+      const SpecSlot &y = spec_slots[spec_fifo[(spec_oldest + i) % Config::SPEC_MAX_INFLIGHT]];
+      lhist.set(lhist.index(y.PC), y.local_hist);
+    }
+  }
+  update_history(s.PC, resolveDir);
+  for(int i = 0; i < spec_count; i++){
+    spec_free[spec_num_free++] = spec_fifo[(spec_oldest + i) % Config::SPEC_MAX_INFLIGHT];
+  }
+  spec_oldest = 0;
+  spec_count = 0;
+  return true;
+}
+
+template<class Config>
+int TageCore<Config>::PredictDeferred(UINT32 PC, bool resolveDir, bool *predDir){
+  if(spec_num_free == 0) return -1;
+  *predDir = GetPrediction(PC);
+  int h = save_slot(PC, *predDir);
+  update_history(PC, resolveDir);
+  return h;
+}
+
+template<class Config>
+void TageCore<Config>::UpdateDeferred(int handle, bool resolveDir){
+  const SpecSlot &s = spec_slots[handle];
+  restore_slot(s);
+  train(s.PC, resolveDir, s.pred_dir);
+  spec_free[spec_num_free++] = handle;
+}
+
+// the lines a prediction for PC touches besides the tagged rows
+template<class Config>
+void TageCore<Config>::prefetch_untagged(UINT32 PC, const UINT32 *sc_hist) const{
+  __builtin_prefetch(&base_table[PC & (BASE_TABLE_SIZE - 1)]);
+  if(Config::USE_LOOP){
+    ltable.prefetch(PC);
+  }
+  if(Config::USE_CF){
+    correct_filter.prefetch(PC);
+  }
+  if(Config::USE_SC){
+    sc.prefetch(PC, sc_hist);
+  }
+}
+
+template<class Config>
+template<class Record>
+UINT64 TageCore<Config>::PredictBlock(const Record *recs, size_t n){
+  const int CHUNK = Config::BATCH_LOOKAHEAD > 0 ? Config::BATCH_LOOKAHEAD : 1;
+  // tags and indices of the next CHUNK branches, computed in one go
+  UINT32 chunk_tag[CHUNK][LANES];
+  UINT32 chunk_idx[CHUNK][LANES];
+  UINT32 chunk_sc_hist[CHUNK][SC_TABLES];
+
+  UINT64 mispred = 0;
+  size_t i = 0;
+  while(i < n){
+    // Outcomes are known in advance and the history depends on nothing
+    // else, so it can run ahead of the tables: hash the next CHUNK branches
+    // and prefetch their rows before any of them is predicted.
+    size_t end = i;
+    int count = 0;
+    for(; end < n && count < CHUNK; end++){
+      const Record &rec = recs[end];
+      if(rec.opType != OPTYPE_BRANCH_COND){
+        // its only effect is on the path history, which runs ahead too
+        TrackOtherInst(rec.PC, (OpType)rec.opType, rec.branchTarget);
+        continue;
+      }
+      if(Config::USE_LOCAL){
+        local_hist = lhist.get(lhist.index(rec.PC));
+      }
+      hash_tables(rec.PC, chunk_idx[count], chunk_tag[count]);
+#pragma GCC unroll 16
+      for(int t = 0; Config::BATCH_LOOKAHEAD && t < NUM_TABLES; t++){
+        tag_table.prefetch(t, chunk_idx[count][t]);
+      }
+      get_sc_hist(chunk_sc_hist[count]);
+      if(Config::BATCH_LOOKAHEAD) prefetch_untagged(rec.PC, chunk_sc_hist[count]);
+      update_history(rec.PC, rec.taken != 0);
+      count++;
+    }
+
+    count = 0;
+    for(; i < end; i++){
+      const Record &rec = recs[i];
+      if(rec.opType != OPTYPE_BRANCH_COND) continue;
+#pragma GCC unroll 16
+      for(int t = 0; t < NUM_TABLES; t++){
+        tag[t] = chunk_tag[count][t];
+        tag_table_idx[t] = chunk_idx[count][t];
+      }
+      for(int t = 0; Config::USE_SC && t < SC_TABLES; t++){
+        sc_hist[t] = chunk_sc_hist[count][t];
+      }
+      count++;
+      bool resolveDir = rec.taken != 0;
+      bool predDir = lookup(rec.PC);
+      train(rec.PC, resolveDir, predDir);
+      mispred += predDir != resolveDir;
+    }
+  }
+  return mispred;
+}
+
+template<class Config>
+UINT32 TageCore<Config>::get_tagged_idx(UINT32 PC, int bank_no){
+  UINT32 h = bank_no < Config::LOCAL_TAGE_TABLES ? fold_bits(local_hist, hist_len[bank_no], INDEX_WIDTH)
+                                                 : idx_fold.comp[bank_no];
+  return (PC ^ h ^ path_hash(bank_no, INDEX_WIDTH)) & ( (1 << INDEX_WIDTH) - 1 );
+}
+
+template<class Config>
+uint16_t TageCore<Config>::get_tag(UINT32 PC, int bank_no){
+  UINT32 h = bank_no < Config::LOCAL_TAGE_TABLES ? fold_bits(local_hist, Config::TAG_HIST_LEN[bank_no], TAG_WIDTH)
+                                                 : tag_fold.comp[bank_no];
+  return ((h + PC * 1000000007) ^ path_hash(bank_no, TAG_WIDTH)) & ((1<<TAG_WIDTH) - 1);
+}
+
+// The youngest min(hist_len, PATH_HIST_LEN) path bits folded to width bits
+// and rotated by the bank number, so that tables sharing a path length
+// still hash differently. 0 without path history.
+template<class Config>
+UINT32 TageCore<Config>::path_hash(int bank_no, int width) const{
+  if(Config::PATH_HIST_LEN == 0) return 0;
+  int len = min(hist_len[bank_no], Config::PATH_HIST_LEN);
+  UINT32 p = phist & (UINT32)((1ull << len) - 1);
+  p ^= p >> width;        // width >= 8 and len <= 32, so two steps fold all
+  p ^= p >> (2 * width);  // four chunks
+  p &= (1u << width) - 1;
+  int r = bank_no % width;
+  return ((p << r) | (p >> (width - r))) & ((1u << width) - 1);
+}
+
+template<class Config>
+void TageCore<Config>::update_path(UINT32 bits){
+  if(Config::PATH_HIST_LEN == 0) return;
+  phist = ((phist << Config::PATH_BITS) ^ (bits & ((1u << Config::PATH_BITS) - 1))) &
+          (UINT32)((1ull << Config::PATH_HIST_LEN) - 1);
+}
+
+template<class Config>
+void TageCore<Config>::update_history(UINT32 PC, bool resolveDir){
+  // a conditional branch's target is not known when it is predicted
+  // speculatively, so only its address goes into the path
+  update_path(PC ^ (PC >> 3));
+  if(Config::USE_LOCAL){
+    lhist.push(lhist.index(PC), resolveDir);
+  }
+  // fold the new outcome in and the bit leaving each window out, then push it
+#pragma GCC unroll 16
+  for(int i = 0; i < NUM_TABLES; i++){
+    idx_fold.update(i, resolveDir, ghr[hist_len[i] - 1]);
+    tag_fold.update(i, resolveDir, ghr[Config::TAG_HIST_LEN[i] - 1]);
+  }
+  if(Config::USE_SC){
+#pragma GCC unroll 16
+    for(int j = 0; j < SC_NUM_TABLES; j++){
+      if(Config::SC_HIST_LEN[j]) sc_fold[j].update(resolveDir, ghr[Config::SC_HIST_LEN[j] - 1]);
+    }
+  }
+  ghr.push(resolveDir);
+}
+
+template<class Config>
+void TageCore<Config>::SetSeed(UINT32 seed){
+  rng_seed = seed;
+  rng.seed(seed);
+  TageRandom fresh = rng;
+  reseed_draw = fresh.next();
+}
+
+template<class Config>
+bool TageCore<Config>::SetHistoryLengths(const int *lens, int n){
+  if(n != NUM_TABLES) return false;
+  for(int i = 0; i < NUM_TABLES; i++){
+    if(lens[i] < 1 || lens[i] > (i < Config::LOCAL_TAGE_TABLES ? Config::LOCAL_HIST_BITS : Config::GHR_LEN)) return false;
+  }
+  for(int i = 0; i < NUM_TABLES; i++){
+    hist_len[i] = lens[i];
+    idx_fold.init(i, hist_len[i], INDEX_WIDTH);
+    for(int j = hist_len[i] - 1; j >= 0; j--){
+      idx_fold.update(i, ghr[j], false);
+    }
+  }
+  return true;
+}
+
+// Parameters a checkpoint must agree on to be restored. Initial values and
+// HIST_LEN are left out: they only matter before the state is loaded, and the
+// current history lengths are saved with the state.
+template<class Config>
+int TageCore<Config>::config_words(UINT32 *words){
+  int n = 0;
+  words[n++] = NUM_TABLES;
+  words[n++] = Config::GHR_LEN;
+  words[n++] = Config::BASE_INDEX_WIDTH;
+  words[n++] = Config::BASE_CTR_MAX;
+  words[n++] = INDEX_WIDTH;
+  words[n++] = TAG_WIDTH;
+  words[n++] = Config::U_WIDTH;
+  words[n++] = Config::CTR_WIDTH;
+  words[n++] = Config::TAGGED_CTR_MAX;
+  words[n++] = Config::TAGGED_WEAK_CORRECT;
+  words[n++] = Config::USE_ALT_MAX;
+  words[n++] = Config::USE_ALT_ON_NEW_ENTRY;
+  words[n++] = Config::USE_ALT_TRAIN_NEW_ONLY;
+  words[n++] = Config::RESEED_ON_ALLOC;
+  words[n++] = Config::U_RESET_PERIOD_LOG;
+  words[n++] = Config::U_RESET_SLICE;
+  words[n++] = Config::USE_LOOP;
+  words[n++] = Config::LOOP_WAYS;
+  words[n++] = Config::USE_CF;
+  words[n++] = Config::PATH_HIST_LEN;
+  words[n++] = Config::PATH_BITS;
+  for(int i = 0; i < NUM_TABLES; i++){
+    words[n++] = Config::TAG_HIST_LEN[i];
+  }
+  words[n++] = Config::USE_SC;
+  if(Config::USE_SC){
+    words[n++] = SC_NUM_TABLES;
+    words[n++] = Config::SC_LOG_SIZE;
+    words[n++] = Config::SC_CTR_BITS;
+    for(int j = 0; j < SC_NUM_TABLES; j++){
+      words[n++] = Config::SC_HIST_LEN[j];
+    }
+  }
+  words[n++] = Config::USE_LOCAL;
+  if(Config::USE_LOCAL){
+    words[n++] = Config::LOCAL_LOG_ENTRIES;
+    words[n++] = Config::LOCAL_HIST_BITS;
+    words[n++] = Config::LOCAL_TAGE_TABLES;
+    words[n++] = SC_LOCAL_TABLES;
+    for(int j = 0; j < SC_LOCAL_TABLES; j++){
+      words[n++] = Config::SC_LOCAL_HIST_LEN[j];
+    }
+  }
+  return n;
+}
+
+template<class Config>
+bool TageCore<Config>::SaveState(FILE *out) const{
+  StateWriter w(out);
+  w.put(TAGE_CKPT_MAGIC, 32);
+  w.put(TAGE_CKPT_VERSION, 16);
+  UINT32 words[CONFIG_WORDS_MAX];
+  int n = config_words(words);
+  w.put(n, 8);
+  for(int i = 0; i < n; i++){
+    w.put(words[i], 32);
+  }
+
+  ghr.save(w);
+  for(int i = 0; i < NUM_TABLES; i++){
+    w.put(hist_len[i], ckpt_bits(Config::GHR_LEN));
+    w.put(idx_fold.comp[i], INDEX_WIDTH);
+    w.put(tag_fold.comp[i], TAG_WIDTH);
+  }
+  w.put(phist, Config::PATH_HIST_LEN);
+  for(UINT32 i = 0; i < BASE_TABLE_SIZE; i++){
+    w.put(base_table[i], ckpt_bits(Config::BASE_CTR_MAX));
+  }
+  tag_table.save(w);
+  w.put(clock, CLOCK_BITS);
+  w.put(u_reset_mask, Config::U_WIDTH);
+  w.put(u_reset_pos, ckpt_bits(tag_table.size()));
+  w.put(use_alt, ckpt_bits(Config::USE_ALT_MAX));
+  w.put(use_cf, 4);
+  w.put(rng_seed, 32);
+  rng.save(w);
+  if(Config::USE_LOOP){
+    ltable.save(w);
+  }
+  if(Config::USE_CF){
+    correct_filter.save(w);
+  }
+  if(Config::USE_SC){
+    for(int j = 0; j < SC_NUM_TABLES; j++){
+      w.put(sc_fold[j].comp, Config::SC_LOG_SIZE);
+    }
+    sc.save(w);
+  }
+  if(Config::USE_LOCAL){
+    lhist.save(w);
+  }
+  return w.finish();
+}
+
+template<class Config>
+bool TageCore<Config>::LoadState(FILE *in){
+  StateReader r(in);
+  if(r.get(32) != TAGE_CKPT_MAGIC || r.get(16) != TAGE_CKPT_VERSION) return false;
+  UINT32 words[CONFIG_WORDS_MAX];
+  int n = config_words(words);
+  if((int)r.get(8) != n) return false;
+  for(int i = 0; i < n; i++){
+    if(r.get(32) != words[i]) return false;
+  }
+
+  ghr.load(r);
+  for(int i = 0; i < NUM_TABLES; i++){
+    hist_len[i] = r.get(ckpt_bits(Config::GHR_LEN));
+    // local tables hash the local history, so they are bounded by it
+    if(hist_len[i] < 1 || hist_len[i] > (i < Config::LOCAL_TAGE_TABLES ? Config::LOCAL_HIST_BITS : Config::GHR_LEN)){
+      return false;
+    }
+    idx_fold.init(i, hist_len[i], INDEX_WIDTH);
+    idx_fold.comp[i] = r.get(INDEX_WIDTH);
+    tag_fold.init(i, Config::TAG_HIST_LEN[i], TAG_WIDTH);
+    tag_fold.comp[i] = r.get(TAG_WIDTH);
+  }
+  phist = r.get(Config::PATH_HIST_LEN);
+  for(UINT32 i = 0; i < BASE_TABLE_SIZE; i++){
+    base_table[i] = r.get(ckpt_bits(Config::BASE_CTR_MAX));
+  }
+  tag_table.load(r);
+  clock = r.get(CLOCK_BITS);
+  u_reset_mask = r.get(Config::U_WIDTH);
+  u_reset_pos = r.get(ckpt_bits(tag_table.size()));
+  use_alt = r.get(ckpt_bits(Config::USE_ALT_MAX));
+  use_cf = r.get(4);
+  SetSeed(r.get(32));
+  rng.load(r);
+  if(Config::USE_LOOP){
+    ltable.load(r);
+  }
+  if(Config::USE_CF){
+    correct_filter.load(r);
+  }
+  if(Config::USE_SC){
+    for(int j = 0; j < SC_NUM_TABLES; j++){
+      sc_fold[j].comp = r.get(Config::SC_LOG_SIZE);
+    }
+    sc.load(r);
+  }
+  if(Config::USE_LOCAL){
+    lhist.load(r);
+  }
+  return r.good();
+}
+
+template<class Config>
+void TageCore<Config>::DumpStats(FILE *out){
+#ifdef TAGE_STATS
+  stats.dump(out);
+#endif
+}
+
+/////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////
+
+template<class Config>
+void    TageCore<Config>::TrackOtherInst(UINT32 PC, OpType opType, UINT32 branchTarget){
+
+  // Called for every instruction that is not a conditional branch; the
+  // other branches extend the path history with their address and target.
+
+  if(Config::PATH_HIST_LEN && opType != OPTYPE_OP){
+    UINT32 x = PC ^ (branchTarget >> 2);
+    update_path(x ^ (x >> 3));
+  }
+}
+
+/////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////
+
+#endif
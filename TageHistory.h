@@ -0,0 +1,113 @@
+#ifndef _TAGE_HISTORY_H_
+#define _TAGE_HISTORY_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+
+// Global history of length orig_len folded down to comp_len bits by XOR-ing
+// comp_len wide chunks together. Kept up to date with a circular shift per
+// branch instead of re-folding the whole history on every lookup.
+class FoldedHistory{
+public:
+  UINT32 comp;
+  int orig_len;
+  int comp_len;
+  int outpoint;
+
+  void init(int original_length, int compressed_length){
+    comp = 0;
+    orig_len = original_length;
+    comp_len = compressed_length;
+    outpoint = orig_len % comp_len;
+  }
+
+  // new_bit enters at position 0, old_bit is the history bit orig_len - 1
+  // that falls off the end with this shift
+  void update(bool new_bit, bool old_bit){
+    comp = (comp << 1) | (UINT32)new_bit;
+    comp ^= (UINT32)old_bit << outpoint;
+    comp ^= comp >> comp_len;
+    comp &= (1u << comp_len) - 1;
+  }
+};
+
+// N FoldedHistory registers stored field by field, so the registers of all
+// tagged tables sit side by side and load as one vector. comp is padded with
+// zeros to PAD entries, a whole number of vectors.
+template<int N, int PAD = N>
+class FoldedHistoryBank{
+public:
+  UINT32 comp[PAD];
+  int orig_len[N];
+  int comp_len[N];
+  int outpoint[N];
+
+  // register i only; clear() zeroes the padding as well
+  void init(int i, int original_length, int compressed_length){
+    comp[i] = 0;
+    orig_len[i] = original_length;
+    comp_len[i] = compressed_length;
+    outpoint[i] = orig_len[i] % comp_len[i];
+  }
+
+  void clear(){ memset(comp, 0, sizeof(comp)); }
+
+  // as FoldedHistory::update, for register i
+  void update(int i, bool new_bit, bool old_bit){
+    UINT32 c = (comp[i] << 1) | (UINT32)new_bit;
+    c ^= (UINT32)old_bit << outpoint[i];
+    c ^= c >> comp_len[i];
+    comp[i] = c & ((1u << comp_len[i]) - 1);
+  }
+};
+
+// Global direction history of up to LEN outcomes kept in a circular buffer,
+// newest outcome at index 0. Pushing an outcome only moves the head, so the
+// cost of an update does not depend on LEN. The buffer keeps SPEC outcomes
+// beyond LEN, so after up to SPEC speculative pushes the head can be moved
+// back to an earlier head() and the history is intact.
+template<int LEN, int SPEC = 0>
+class GlobalHistory{
+public:
+  void init(){
+    memset(bits, 0, sizeof(bits));
+    ptr = 0;
+  }
+
+  bool operator[](int i) const{
+    return bits[(ptr + i) & (BUF_SIZE - 1)];
+  }
+
+  void push(bool taken){
+    ptr = (ptr - 1) & (BUF_SIZE - 1);
+    bits[ptr] = taken;
+  }
+
+  int head() const{ return ptr; }
+  void rewind(int head){ ptr = head; }
+
+  // oldest outcome first, so load() can simply push them back in order
+  void save(StateWriter &w) const{
+    for(int i = LEN - 1; i >= 0; i--){
+      w.put((*this)[i], 1);
+    }
+  }
+
+  void load(StateReader &r){
+    init();
+    for(int i = 0; i < LEN; i++){
+      push(r.get(1));
+    }
+  }
+
+private:
+  static constexpr int buf_size(int n){
+    return n <= 1 ? 1 : 2 * buf_size((n + 1) / 2);
+  }
+  static const int BUF_SIZE = buf_size(LEN + SPEC);
+
+  uint8_t bits[BUF_SIZE];
+  int ptr;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef _TAGE_RANDOM_H_
+#define _TAGE_RANDOM_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+
+// Random source owned by each predictor, so instances neither share a
+// sequence nor contend on libc's rand() lock, and a run depends only on the
+// seed and the trace. It is the additive lagged-Fibonacci generator behind
+// glibc's rand() (x[i] = x[i-3] + x[i-31], output x[i] >> 1), seeded the same
+// way, so a predictor draws exactly the numbers srand()/rand() used to give
+// it and the results of the existing configurations are unchanged. A draw
+// is one add and two index steps.
+class TageRandom{
+public:
+  static const int DEG = 31;
+  static const int SEP = 3;
+
+  void seed(UINT32 s){
+    INT32 word = s ? (INT32)s : 1;
+    r[0] = word;
+    for(int i = 1; i < DEG; i++){
+      // 16807 * word % (2^31 - 1) without overflow (Schrage)
+      INT32 hi = word / 127773;
+      INT32 lo = word % 127773;
+      word = 16807 * lo - 2836 * hi;
+      if(word < 0) word += 2147483647;
+      r[i] = word;
+    }
+    front = SEP;
+    rear = 0;
+    for(int i = 0; i < 10 * DEG; i++){
+      next();
+    }
+  }
+
+  // 31 random bits
+  UINT32 next(){
+    r[front] += r[rear];
+    UINT32 v = r[front] >> 1;
+    front = front + 1 == DEG ? 0 : front + 1;
+    rear = rear + 1 == DEG ? 0 : rear + 1;
+    return v;
+  }
+
+  void save(StateWriter &w) const{
+    for(int i = 0; i < DEG; i++){
+      w.put(r[i], 32);
+    }
+    w.put(rear, ckpt_bits(DEG - 1));
+  }
+
+  void load(StateReader &r_in){
+    for(int i = 0; i < DEG; i++){
+      r[i] = r_in.get(32);
+    }
+    rear = r_in.get(ckpt_bits(DEG - 1)) % DEG;
+    front = (rear + SEP) % DEG;
+  }
+
+private:
+  UINT32 r[DEG];
+  int front;  // always SEP ahead of rear
+  int rear;
+};
+
+#endif
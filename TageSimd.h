@@ -0,0 +1,144 @@
+#ifndef _TAGE_SIMD_H_
+#define _TAGE_SIMD_H_
+
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TAGE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Vector kernels for the lookup of all tagged tables at once: one lane per
+// table. They are compiled for AVX2 and AVX-512 with function target
+// attributes, so the build flags stay generic, and chosen at run time
+// (tage_simd_level()); every kernel returns exactly what the scalar one does.
+enum TageSimdLevel{
+  TAGE_SIMD_SCALAR = 0,
+  TAGE_SIMD_AVX2 = 1,
+  TAGE_SIMD_AVX512 = 2,
+};
+
+// The level named by the TAGE_SIMD environment variable (scalar, avx2,
+// avx512, or auto for the best one), capped by what the CPU supports.
+// Scalar when unset: on the Xeons we measured, gathering the 8 entries costs
+// more than 8 plain loads, so the vector kernels are opt-in.
+inline int tage_simd_detect(){
+  int level = TAGE_SIMD_SCALAR;
+#ifdef TAGE_SIMD_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")){
+    level = __builtin_cpu_supports("avx512f") ? TAGE_SIMD_AVX512 : TAGE_SIMD_AVX2;
+  }
+#endif
+  const char *want = getenv("TAGE_SIMD");
+  if(!want) return TAGE_SIMD_SCALAR;
+  if(!strcmp(want, "auto")) return level;
+  int w = !strcmp(want, "avx512") ? TAGE_SIMD_AVX512 : !strcmp(want, "avx2") ? TAGE_SIMD_AVX2 : TAGE_SIMD_SCALAR;
+  return min(level, w);
+}
+
+inline int tage_simd_level(){
+  static const int level = tage_simd_detect();
+  return level;
+}
+
+// N tables of 2^INDEX_BITS 16-bit entries in one flat array, table t at
+// t << INDEX_BITS, the tag in the bits from TAG_SHIFT up. Every array passed
+// to the kernels is LANES long; only the first N lanes are read from the
+// tables or reported.
+template<int N, int INDEX_BITS, int TAG_BITS, int TAG_SHIFT>
+struct TageLanes{
+  static_assert(N >= 1 && N <= 16, "one lane per table, 16 at most");
+  static const int LANES = N <= 8 ? 8 : 16;
+  static const UINT32 LIVE = (1u << N) - 1;
+
+  // idx[t] = (PC ^ icomp[t]) & index mask and
+  // tag[t] = (tcomp[t] + PC * 1000000007) & tag mask
+  static void hash(int level, UINT32 PC, const UINT32 *icomp, const UINT32 *tcomp, UINT32 *idx, UINT32 *tag){
+#ifdef TAGE_SIMD_X86
+    if(level >= TAGE_SIMD_AVX2){
+      hash_avx2(PC, icomp, tcomp, idx, tag);
+      return;
+    }
+#endif
+    hash_scalar(PC, icomp, tcomp, idx, tag);
+  }
+
+  // bit t set when the entry at idx[t] of table t holds tag[t]
+  static UINT32 hits(int level, const uint16_t *entries, const UINT32 *idx, const UINT32 *tag){
+#ifdef TAGE_SIMD_X86
+    if(level >= TAGE_SIMD_AVX512 && N > 8) return hits_avx512(entries, idx, tag);
+    if(level >= TAGE_SIMD_AVX2) return hits_avx2(entries, idx, tag);
+#endif
+    return hits_scalar(entries, idx, tag);
+  }
+
+  static void hash_scalar(UINT32 PC, const UINT32 *icomp, const UINT32 *tcomp, UINT32 *idx, UINT32 *tag){
+#pragma GCC unroll 16
+    for(int t = 0; t < N; t++){
+      idx[t] = (PC ^ icomp[t]) & ((1u << INDEX_BITS) - 1);
+      tag[t] = (tcomp[t] + PC * 1000000007) & ((1u << TAG_BITS) - 1);
+    }
+  }
+
+  static UINT32 hits_scalar(const uint16_t *entries, const UINT32 *idx, const UINT32 *tag){
+    UINT32 m = 0;
+#pragma GCC unroll 16
+    for(int t = 0; t < N; t++){
+      m |= (UINT32)(entries[((UINT32)t << INDEX_BITS) + idx[t]] >> TAG_SHIFT == tag[t]) << t;
+    }
+    return m;
+  }
+
+#ifdef TAGE_SIMD_X86
+  __attribute__((target("avx2")))
+  static void hash_avx2(UINT32 PC, const UINT32 *icomp, const UINT32 *tcomp, UINT32 *idx, UINT32 *tag){
+    const __m256i pc = _mm256_set1_epi32(PC);
+    const __m256i pc_tag = _mm256_set1_epi32(PC * 1000000007);
+    for(int g = 0; g < LANES; g += 8){
+      __m256i ic = _mm256_loadu_si256((const __m256i *)(icomp + g));
+      __m256i tc = _mm256_loadu_si256((const __m256i *)(tcomp + g));
+      __m256i i = _mm256_and_si256(_mm256_xor_si256(pc, ic), _mm256_set1_epi32((1u << INDEX_BITS) - 1));
+      __m256i t = _mm256_and_si256(_mm256_add_epi32(tc, pc_tag), _mm256_set1_epi32((1u << TAG_BITS) - 1));
+      _mm256_storeu_si256((__m256i *)(idx + g), i);
+      _mm256_storeu_si256((__m256i *)(tag + g), t);
+    }
+  }
+
+  // A 32-bit gather at a 16-bit entry also reads the entry after it (the
+  // table keeps a spare one at the end), which the tag mask drops. Dead
+  // lanes read entry 0 and are masked off.
+  __attribute__((target("avx2")))
+  static UINT32 hits_avx2(const uint16_t *entries, const UINT32 *idx, const UINT32 *tag){
+    UINT32 m = 0;
+    for(int g = 0; g < LANES; g += 8){
+      __m256i lane = _mm256_add_epi32(_mm256_set1_epi32(g), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+      __m256i live = _mm256_cmpgt_epi32(_mm256_set1_epi32(N), lane);
+      __m256i flat = _mm256_add_epi32(_mm256_slli_epi32(lane, INDEX_BITS), _mm256_loadu_si256((const __m256i *)(idx + g)));
+      flat = _mm256_and_si256(flat, live);
+      __m256i e = _mm256_i32gather_epi32((const int *)entries, flat, 2);
+      __m256i t = _mm256_and_si256(_mm256_srli_epi32(e, TAG_SHIFT), _mm256_set1_epi32((1u << TAG_BITS) - 1));
+      __m256i eq = _mm256_cmpeq_epi32(t, _mm256_loadu_si256((const __m256i *)(tag + g)));
+      m |= (UINT32)_mm256_movemask_ps(_mm256_castsi256_ps(eq)) << g;
+    }
+    return m & LIVE;
+  }
+
+  // all 16 lanes in one gather
+  __attribute__((target("avx512f")))
+  static UINT32 hits_avx512(const uint16_t *entries, const UINT32 *idx, const UINT32 *tag){
+    __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i flat = _mm512_maskz_add_epi32((__mmask16)LIVE, _mm512_slli_epi32(lane, INDEX_BITS),
+                                          _mm512_loadu_si512(idx));
+    // the masked forms, so no lane starts out undefined
+    __m512i e = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), (__mmask16)LIVE, flat, entries, 2);
+    __m512i t = _mm512_and_si512(_mm512_maskz_srli_epi32((__mmask16)LIVE, e, TAG_SHIFT),
+                                 _mm512_set1_epi32((1u << TAG_BITS) - 1));
+    return _mm512_mask_cmpeq_epi32_mask((__mmask16)LIVE, t, _mm512_loadu_si512(tag));
+  }
+#endif
+};
+
+#endif
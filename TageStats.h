@@ -0,0 +1,57 @@
+#ifndef _TAGE_STATS_H_
+#define _TAGE_STATS_H_
+
+#include "utils.h"
+
+// Per-component event counters of a TAGE predictor with N tagged tables.
+// Only compiled into the predictor with -DTAGE_STATS, so a normal build pays
+// nothing for them. Component 0 is the base table, component i + 1 is tagged
+// table i.
+template<int N>
+struct TageStats{
+  UINT64 branches;
+  UINT64 mispredictions;
+  UINT64 hits[N];                   // tag matches in tagged table i
+  UINT64 provider[N + 1];           // component provided pred
+  UINT64 provider_mispred[N + 1];   // ... and pred was wrong
+  UINT64 alt_override[N];           // new entry in table i, altpred used instead
+  UINT64 alt_override_correct[N];   // ... and altpred was right
+  UINT64 alloc[N];                  // entries allocated in table i
+  UINT64 alloc_fail;                // misprediction with no u == 0 entry to take
+  UINT64 u_decrement[N];            // u decremented in table i, by a failed allocation
+                                    // or a wrong provider that altpred would have fixed
+  UINT64 loop_override;             // loop predictor supplied the prediction
+  UINT64 loop_override_correct;
+  UINT64 cf_flip;                   // corrector filter reversed the tage prediction
+  UINT64 cf_flip_correct;
+
+  void init(){
+    memset(this, 0, sizeof(*this));
+  }
+
+  void dump(FILE *out) const{
+    fprintf(out, "  TAGE_STATS\n");
+    fprintf(out, "  %-6s %12s %12s %12s %12s %12s %12s %12s\n", "COMP", "HITS", "PROVIDER", "PROV_MISP",
+            "ALT_OVERRIDE", "ALT_CORRECT", "ALLOC", "U_DEC");
+    fprintf(out, "  %-6s %12s %12llu %12llu %12s %12s %12s %12s\n", "base", "-",
+            (unsigned long long)provider[0], (unsigned long long)provider_mispred[0], "-", "-", "-", "-");
+    for(int i = 0; i < N; i++){
+      char name[8];
+      snprintf(name, sizeof(name), "T%d", i + 1);
+      fprintf(out, "  %-6s %12llu %12llu %12llu %12llu %12llu %12llu %12llu\n", name,
+              (unsigned long long)hits[i], (unsigned long long)provider[i + 1],
+              (unsigned long long)provider_mispred[i + 1], (unsigned long long)alt_override[i],
+              (unsigned long long)alt_override_correct[i], (unsigned long long)alloc[i],
+              (unsigned long long)u_decrement[i]);
+    }
+    fprintf(out, "  BRANCHES             \t : %10llu\n", (unsigned long long)branches);
+    fprintf(out, "  MISPREDICTIONS       \t : %10llu\n", (unsigned long long)mispredictions);
+    fprintf(out, "  ALLOC_FAIL           \t : %10llu\n", (unsigned long long)alloc_fail);
+    fprintf(out, "  LOOP_OVERRIDE        \t : %10llu (correct %llu)\n",
+            (unsigned long long)loop_override, (unsigned long long)loop_override_correct);
+    fprintf(out, "  CF_FLIP              \t : %10llu (correct %llu)\n",
+            (unsigned long long)cf_flip, (unsigned long long)cf_flip_correct);
+  }
+};
+
+#endif
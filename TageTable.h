@@ -0,0 +1,89 @@
+#ifndef _TAGE_TABLE_H_
+#define _TAGE_TABLE_H_
+
+#include "utils.h"
+#include "TageCheckpoint.h"
+#include "TageSimd.h"
+
+// Storage for all tagged tables of a TAGE predictor. Each entry is packed into
+// one 16-bit word laid out as | tag | u | ctr | (ctr in the low bits), and all
+// tables share one contiguous array, table t starting at t << INDEX_BITS.
+// One spare entry after the last table lets a 32-bit gather read any entry.
+template<int NUM_TABLES, int INDEX_BITS, int TAG_BITS, int U_BITS, int CTR_BITS>
+class PackedTageTable{
+public:
+  static const int U_SHIFT = CTR_BITS;
+  static const int TAG_SHIFT = CTR_BITS + U_BITS;
+  static const uint16_t CTR_MASK = (1 << CTR_BITS) - 1;
+  static const uint16_t U_MASK = ((1 << U_BITS) - 1) << U_SHIFT;
+  static const uint16_t TAG_MASK = ((1 << TAG_BITS) - 1) << TAG_SHIFT;
+  static const UINT32 SIZE = (UINT32)NUM_TABLES << INDEX_BITS;
+  static_assert(TAG_BITS + U_BITS + CTR_BITS <= 16, "tagged entry must fit in 16 bits");
+  typedef TageLanes<NUM_TABLES, INDEX_BITS, TAG_BITS, TAG_SHIFT> Lanes;
+
+  void init(UINT32 ctr_init){
+    for(UINT32 i = 0; i < SIZE; i++){
+      entries[i] = ctr_init & CTR_MASK;
+    }
+    entries[SIZE] = 0;
+  }
+
+  UINT32 size() const{ return SIZE; }
+
+  UINT32 tag(int t, UINT32 idx) const{ return entry(t, idx) >> TAG_SHIFT; }
+  UINT32 u(int t, UINT32 idx) const{ return (entry(t, idx) & U_MASK) >> U_SHIFT; }
+  UINT32 ctr(int t, UINT32 idx) const{ return entry(t, idx) & CTR_MASK; }
+
+  // bit t set when entry idx[t] of table t holds tag[t], for every table at
+  // once; idx and tag are Lanes::LANES long
+  UINT32 hit_mask(int simd, const UINT32 *idx, const UINT32 *tag) const{
+    return Lanes::hits(simd, entries, idx, tag);
+  }
+
+  void set_u(int t, UINT32 idx, UINT32 v){
+    uint16_t &e = entry(t, idx);
+    e = (e & ~U_MASK) | (v << U_SHIFT);
+  }
+
+  void set_ctr(int t, UINT32 idx, UINT32 v){
+    uint16_t &e = entry(t, idx);
+    e = (e & ~CTR_MASK) | v;
+  }
+
+  void set(int t, UINT32 idx, UINT32 tag_v, UINT32 u_v, UINT32 ctr_v){
+    entry(t, idx) = (tag_v << TAG_SHIFT) | (u_v << U_SHIFT) | ctr_v;
+  }
+
+  // keep only the u bits set in mask for entries [begin, end) of the flat
+  // storage, one linear pass
+  void reset_u(UINT32 mask, UINT32 begin, UINT32 end){
+    uint16_t keep = ~U_MASK | ((mask << U_SHIFT) & U_MASK);
+    for(UINT32 i = begin; i < end; i++){
+      entries[i] &= keep;
+    }
+  }
+
+  void reset_u(UINT32 mask){ reset_u(mask, 0, SIZE); }
+
+  void prefetch(int t, UINT32 idx) const{ __builtin_prefetch(&entries[((UINT32)t << INDEX_BITS) + idx]); }
+
+  void save(StateWriter &w) const{
+    for(UINT32 i = 0; i < SIZE; i++){
+      w.put(entries[i], TAG_BITS + U_BITS + CTR_BITS);
+    }
+  }
+
+  void load(StateReader &r){
+    for(UINT32 i = 0; i < SIZE; i++){
+      entries[i] = r.get(TAG_BITS + U_BITS + CTR_BITS);
+    }
+  }
+
+private:
+  uint16_t entries[SIZE + 1];
+
+  uint16_t &entry(int t, UINT32 idx){ return entries[((UINT32)t << INDEX_BITS) + idx]; }
+  uint16_t entry(int t, UINT32 idx) const{ return entries[((UINT32)t << INDEX_BITS) + idx]; }
+};
+
+#endif
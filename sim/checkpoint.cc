@@ -0,0 +1,112 @@
+#include "checkpoint.h"
+#include "TageCheckpoint.h"
+
+static bool write_header(StateWriter &w, const char *spec, UINT64 position){
+  size_t len = strlen(spec);
+  w.put(SIM_CKPT_MAGIC, 32);
+  w.put(SIM_CKPT_VERSION, 16);
+  w.put(position, 64);
+  w.put(len, 16);
+  for(size_t i = 0; i < len; i++){
+    w.put((UINT8)spec[i], 8);
+  }
+  return w.finish();
+}
+
+static bool read_header(StateReader &r, std::string *spec, UINT64 *position){
+  if(r.get(32) != SIM_CKPT_MAGIC || r.get(16) != SIM_CKPT_VERSION) return false;
+  *position = r.get(64);
+  size_t len = r.get(16);
+  spec->clear();
+  for(size_t i = 0; i < len; i++){
+    spec->push_back((char)r.get(8));
+  }
+  return r.good();
+}
+
+bool save_checkpoint(const char *path, BranchPredictor *pred, const char *spec, UINT64 position){
+  FILE *out = fopen(path, "wb");
+  if(out == NULL){
+    fprintf(stderr, "cannot write checkpoint %s\n", path);
+    return false;
+  }
+  StateWriter w(out);
+  bool ok = write_header(w, spec ? spec : "", position) && pred->SaveState(out);
+  ok = (fclose(out) == 0) && ok;
+  if(!ok){
+    fprintf(stderr, "failed to save checkpoint %s\n", path);
+  }
+  return ok;
+}
+
+bool read_checkpoint_header(const char *path, std::string *spec, UINT64 *position){
+  FILE *in = fopen(path, "rb");
+  if(in == NULL){
+    fprintf(stderr, "cannot open checkpoint %s\n", path);
+    return false;
+  }
+  StateReader r(in);
+  bool ok = read_header(r, spec, position);
+  fclose(in);
+  if(!ok){
+    fprintf(stderr, "%s is not a checkpoint of this version\n", path);
+  }
+  return ok;
+}
+
+bool load_checkpoint(const char *path, BranchPredictor *pred){
+  FILE *in = fopen(path, "rb");
+  if(in == NULL){
+    fprintf(stderr, "cannot open checkpoint %s\n", path);
+    return false;
+  }
+  StateReader r(in);
+  std::string spec;
+  UINT64 position;
+  bool ok = read_header(r, &spec, &position) && pred->LoadState(in);
+  fclose(in);
+  if(!ok){
+    fprintf(stderr, "checkpoint %s does not match this configuration\n", path);
+  }
+  return ok;
+}
+
+static std::string config_name(const char *spec){
+  const char *colon = strchr(spec, ':');
+  return colon ? std::string(spec, colon - spec) : std::string(spec);
+}
+
+WarmStart::~WarmStart(){
+  for(auto &w : warmed){
+    delete w.second;
+  }
+}
+
+bool WarmStart::add(const char *spec){
+  std::string name = config_name(spec);
+  if(warmed.count(name)) return true;
+  BranchPredictor *pred = create_predictor(name.c_str());
+  if(pred == NULL) return false;
+  if(!load_checkpoint(path.c_str(), pred)){
+    delete pred;
+    return false;
+  }
+  warmed[name] = pred;
+  return true;
+}
+
+BranchPredictor *WarmStart::fork(const char *spec) const{
+  auto it = warmed.find(config_name(spec));
+  if(it == warmed.end()) return NULL;
+  BranchPredictor *pred = it->second->Clone();
+  if(pred == NULL){
+    fprintf(stderr, "%s cannot be forked\n", spec);
+    return NULL;
+  }
+  const char *colon = strchr(spec, ':');
+  if(colon && !apply_predictor_options(pred, colon + 1)){
+    delete pred;
+    return NULL;
+  }
+  return pred;
+}
@@ -0,0 +1,52 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include "utils.h"
+#include "registry.h"
+#include <map>
+#include <string>
+
+// A replay checkpoint: the configuration spec that was replayed ("" for the
+// PREDICTOR compiled into the driver), how many trace records it had consumed,
+// then the predictor's own versioned state (BranchPredictor::SaveState).
+// Warming a predictor once and restoring it for every experiment skips the
+// warmup replay, and -- for plain trace files -- the decoding of the prefix.
+
+#define SIM_CKPT_MAGIC   0x43534754u // "TGSC"
+#define SIM_CKPT_VERSION 1
+
+bool save_checkpoint(const char *path, BranchPredictor *pred, const char *spec, UINT64 position);
+
+// read only the header, to learn which configuration to build
+bool read_checkpoint_header(const char *path, std::string *spec, UINT64 *position);
+
+// restore the predictor state saved in path into pred, which must have been
+// built from the same configuration
+bool load_checkpoint(const char *path, BranchPredictor *pred);
+
+// Forks predictors from one checkpoint. add() restores the checkpoint once
+// per configuration name; fork() clones that warmed predictor (one memcpy
+// for the TAGE configs) and applies the spec's knobs to the copy, so many
+// experiments can start from the same warm state without reading the file
+// or replaying a warmup again. Call add() for every spec first; after that
+// fork() may be called from any number of threads.
+class WarmStart{
+public:
+  explicit WarmStart(const char *path): path(path){}
+  ~WarmStart();
+
+  // false, with a message on stderr, if spec is unknown or does not match
+  // the checkpoint
+  bool add(const char *spec);
+  // NULL if add(spec) did not succeed or the predictor cannot be cloned
+  BranchPredictor *fork(const char *spec) const;
+
+private:
+  std::string path;
+  std::map<std::string, BranchPredictor *> warmed; // by configuration name
+
+  WarmStart(const WarmStart &) = delete;
+  WarmStart &operator=(const WarmStart &) = delete;
+};
+
+#endif
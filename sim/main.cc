@@ -0,0 +1,309 @@
+#include "utils.h"
+#include "tracer.h"
+#include "predictor.h"
+#include "registry.h"
+#include "profile.h"
+#include "replay.h"
+#include "checkpoint.h"
+#include <string>
+#include <chrono>
+#include <vector>
+
+// Standalone replay driver: streams a trace through the PREDICTOR built
+// alongside it (or any configuration from the registry), the same way the
+// cbp4 harness does, and reports MPKI plus replay throughput. Given several
+// -c options it decodes the trace once and sweeps all of them in one pass.
+// -S/-R save the warmed predictor at the end of a run and resume from it.
+
+static void usage(const char *prog){
+  fprintf(stderr, "usage: %s [-c config]... [-j threads] [-n max_instructions] [-p top_n] [-P profile_out]\n"
+                  "          [-S checkpoint_out] [-R checkpoint_in] [-s depth | -d delay] <trace | ->\n", prog);
+  fprintf(stderr, "  -c spec  replay with a registered configuration instead of PREDICTOR,\n");
+  fprintf(stderr, "           e.g. -c predictor, -c predictor:hist=8,40,200,640 or\n");
+  fprintf(stderr, "           -c predictor:seed=7;\n");
+  fprintf(stderr, "           repeat to sweep several configurations in one pass\n");
+  fprintf(stderr, "  -j N     spread the sweep's predictors over N threads\n");
+  fprintf(stderr, "  -l       list the registered configurations\n");
+  fprintf(stderr, "  -p N     report the N most mispredicted branch PCs\n");
+  fprintf(stderr, "  -P file  write the per-PC profile of every branch to file\n");
+  fprintf(stderr, "  -S file  save the predictor state and trace position when the run ends\n");
+  fprintf(stderr, "  -R file  restore a saved predictor and continue its trace where it stopped;\n");
+  fprintf(stderr, "           without -c the saved configuration is used\n");
+  fprintf(stderr, "  -s N     predict up to N branches ahead of resolution with speculative\n");
+  fprintf(stderr, "           history, repairing it on mispredictions\n");
+  fprintf(stderr, "  -d D     apply each update D branches late: N, N-M (uniform) or\n");
+  fprintf(stderr, "           geo:MEAN[:MAX] (geometric); tables are read stale meanwhile\n");
+  exit(1);
+}
+
+static void print_counts(const char *trace_path, const char *config, const ReplayCounts &c, double elapsed){
+  printf("  TRACE \t : %s \n", trace_path);
+  if(config){
+    printf("  CONFIG               \t : %s\n", config);
+  }
+  printf("  NUM_INSTRUCTIONS     \t : %10llu\n", (unsigned long long)c.num_inst);
+  printf("  NUM_BR               \t : %10llu\n", (unsigned long long)c.num_br);
+  printf("  NUM_UNCOND_BR        \t : %10llu\n", (unsigned long long)c.num_uncond_br);
+  printf("  NUM_MISPREDICTIONS   \t : %10llu\n", (unsigned long long)c.num_mispred);
+  printf("  MISPRED_PER_1K_INST  \t : %10.4f\n", c.mpki());
+  printf("  ELAPSED_SECONDS      \t : %10.4f\n", elapsed);
+  printf("  BRANCHES_PER_SEC     \t : %10.0f\n", elapsed > 0 ? c.num_br / elapsed : 0.0);
+}
+
+// Build the predictor for config (NULL for the compiled-in PREDICTOR) and,
+// given a checkpoint, restore its state. Knobs in the spec are applied again
+// after the restore so they override the saved ones.
+static BranchPredictor *make_predictor(const char *config, const char *ckpt_in){
+  BranchPredictor *pred = config ? create_predictor(config) : new PredictorAdapter<PREDICTOR>();
+  if(pred == NULL){
+    list_predictors(stderr);
+    return NULL;
+  }
+  if(ckpt_in){
+    const char *colon = config ? strchr(config, ':') : NULL;
+    if(!load_checkpoint(ckpt_in, pred) || (colon && !apply_predictor_options(pred, colon + 1))){
+      delete pred;
+      return NULL;
+    }
+  }
+  return pred;
+}
+
+static int run_single(TraceReader *reader, const char *trace_path, const char *config, UINT64 max_inst,
+                      int top_n, const char *profile_path, const char *ckpt_in, const char *ckpt_out,
+                      UINT64 position, int spec_depth, const UpdateDelay *delay){
+  BranchPredictor *brpred = make_predictor(config, ckpt_in);
+  if(brpred == NULL) return 1;
+  if(spec_depth > brpred->MaxInFlight()){
+    fprintf(stderr, "this predictor supports at most %d branches in flight\n", brpred->MaxInFlight());
+    delete brpred;
+    return 1;
+  }
+  // only a max the user gave is an error; the geometric default is capped
+  UpdateDelay capped;
+  if(delay && !delay->max_given && delay->max >= brpred->MaxInFlight()){
+    capped = *delay;
+    capped.max = std::max(brpred->MaxInFlight() - 1, 0);
+    delay = &capped;
+  }
+  if(delay && delay->max >= brpred->MaxInFlight()){
+    fprintf(stderr, "update delays must stay below %d for this predictor\n", brpred->MaxInFlight());
+    delete brpred;
+    return 1;
+  }
+  BranchProfile *profile = (top_n > 0 || profile_path) ? new BranchProfile() : NULL;
+
+  ReplayCounts counts;
+  auto start = std::chrono::steady_clock::now();
+  if(spec_depth > 0){
+    replay_stream_speculative(reader, brpred, spec_depth, max_inst, &counts);
+  }
+  else if(delay){
+    replay_stream_delayed(reader, brpred, *delay, max_inst, &counts);
+  }
+  else{
+    replay_stream(reader, brpred, max_inst, &counts, profile);
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  print_counts(trace_path, config, counts, elapsed);
+  if(spec_depth > 0){
+    printf("  SPEC_DEPTH           \t : %10d\n", spec_depth);
+    printf("  NUM_SQUASHED_PRED    \t : %10llu\n", (unsigned long long)counts.num_squashed);
+  }
+  if(delay){
+    if(delay->kind == UpdateDelay::FIXED){
+      printf("  UPDATE_DELAY         \t : %10d\n", delay->min);
+    }
+    else if(delay->kind == UpdateDelay::UNIFORM){
+      printf("  UPDATE_DELAY         \t : uniform %d-%d\n", delay->min, delay->max);
+    }
+    else{
+      printf("  UPDATE_DELAY         \t : geometric mean %g, max %d\n", delay->mean, delay->max);
+    }
+  }
+  if(ckpt_in){
+    printf("  RESUMED_AT_INST      \t : %10llu\n", (unsigned long long)position);
+  }
+
+#ifdef TAGE_STATS
+  brpred->DumpStats(stdout);
+#endif
+
+  if(profile){
+    if(top_n > 0){
+      profile->report_top(stdout, top_n, counts.num_mispred);
+    }
+    if(profile_path){
+      FILE *out = fopen(profile_path, "w");
+      if(out == NULL){
+        fprintf(stderr, "cannot write profile %s\n", profile_path);
+      }
+      else{
+        profile->dump(out);
+        fclose(out);
+      }
+    }
+    delete profile;
+  }
+
+  int status = 0;
+  if(ckpt_out && !save_checkpoint(ckpt_out, brpred, config, position + counts.num_inst)){
+    status = 1;
+  }
+  delete brpred;
+  return status;
+}
+
+static void delete_predictors(std::vector<BranchPredictor *> &preds){
+  for(BranchPredictor *pred : preds){
+    delete pred;
+  }
+  preds.clear();
+}
+
+static int run_sweep(TraceReader *reader, const char *trace_path, const std::vector<const char *> &configs,
+                     int threads, UINT64 max_inst, const char *ckpt_in){
+  int n = configs.size();
+  std::vector<BranchPredictor *> preds(n, NULL);
+  bool ok = true;
+  if(ckpt_in){
+    // the checkpoint is read once per configuration name, the rest are forks
+    WarmStart warm(ckpt_in);
+    for(int i = 0; i < n && ok; i++){
+      preds[i] = warm.add(configs[i]) ? warm.fork(configs[i]) : NULL;
+      ok = preds[i] != NULL;
+    }
+  }
+  else{
+    for(int i = 0; i < n && ok; i++){
+      preds[i] = make_predictor(configs[i], NULL);
+      ok = preds[i] != NULL;
+    }
+  }
+  if(!ok){
+    // the predictors built before the failing one
+    delete_predictors(preds);
+    return 1;
+  }
+  std::vector<ReplayCounts> counts(n);
+
+  auto start = std::chrono::steady_clock::now();
+  replay_sweep(reader, preds.data(), n, threads, max_inst, counts.data());
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  UINT64 total_br = 0;
+  printf("  TRACE \t : %s \n", trace_path);
+  printf("  NUM_INSTRUCTIONS     \t : %10llu\n", (unsigned long long)counts[0].num_inst);
+  printf("  NUM_BR               \t : %10llu\n", (unsigned long long)counts[0].num_br);
+  printf("  %-40s %14s %12s\n", "CONFIG", "MISPREDICTIONS", "MPKI");
+  for(int i = 0; i < n; i++){
+    printf("  %-40s %14llu %12.4f\n", configs[i], (unsigned long long)counts[i].num_mispred, counts[i].mpki());
+    total_br += counts[i].num_br;
+  }
+  printf("  ELAPSED_SECONDS      \t : %10.4f\n", elapsed);
+  printf("  BRANCHES_PER_SEC     \t : %10.0f (summed over %d configs)\n", elapsed > 0 ? total_br / elapsed : 0.0, n);
+
+  delete_predictors(preds);
+  return 0;
+}
+
+int main(int argc, char *argv[]){
+  UINT64 max_inst = 0;
+  const char *trace_path = NULL;
+  int top_n = 0;
+  const char *profile_path = NULL;
+  std::vector<const char *> configs;
+  int threads = 1;
+  const char *ckpt_in = NULL;
+  const char *ckpt_out = NULL;
+  int spec_depth = 0;
+  const char *delay_spec = NULL;
+  UpdateDelay delay;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+      max_inst = strtoull(argv[++i], NULL, 0);
+    }
+    else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc){
+      configs.push_back(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+      threads = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-l") == 0){
+      list_predictors(stdout);
+      return 0;
+    }
+    else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc){
+      top_n = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-P") == 0 && i + 1 < argc){
+      profile_path = argv[++i];
+    }
+    else if(strcmp(argv[i], "-S") == 0 && i + 1 < argc){
+      ckpt_out = argv[++i];
+    }
+    else if(strcmp(argv[i], "-R") == 0 && i + 1 < argc){
+      ckpt_in = argv[++i];
+    }
+    else if(strcmp(argv[i], "-d") == 0 && i + 1 < argc){
+      delay_spec = argv[++i];
+      if(!delay.parse(delay_spec)){
+        fprintf(stderr, "bad update delay '%s'\n", delay_spec);
+        return 1;
+      }
+    }
+    else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+      spec_depth = atoi(argv[++i]);
+    }
+    else if(argv[i][0] == '-' && argv[i][1] != '\0'){
+      usage(argv[0]);
+    }
+    else{
+      trace_path = argv[i];
+    }
+  }
+  if(trace_path == NULL) usage(argv[0]);
+  if((spec_depth || delay_spec) && (top_n > 0 || profile_path)){
+    fprintf(stderr, "-p/-P cannot be combined with -s/-d\n");
+    return 1;
+  }
+  if(spec_depth && delay_spec){
+    fprintf(stderr, "-s and -d are separate modes\n");
+    return 1;
+  }
+
+  TraceReader reader;
+  if(!reader.open(trace_path)){
+    fprintf(stderr, "cannot open trace %s\n", trace_path);
+    return 1;
+  }
+
+  // the checkpoint names its configuration and where in the trace it stopped
+  std::string saved_spec;
+  UINT64 position = 0;
+  if(ckpt_in){
+    if(!read_checkpoint_header(ckpt_in, &saved_spec, &position)) return 1;
+    if(configs.empty() && !saved_spec.empty()){
+      configs.push_back(saved_spec.c_str());
+    }
+    if(reader.Skip(position) != position){
+      fprintf(stderr, "trace %s is shorter than the checkpoint position %llu\n", trace_path,
+              (unsigned long long)position);
+      return 1;
+    }
+  }
+
+  if(configs.size() > 1){
+    if(top_n > 0 || profile_path || ckpt_out || spec_depth || delay_spec){
+      fprintf(stderr, "-p/-P/-S/-s/-d apply to a single configuration only\n");
+      return 1;
+    }
+    int status = run_sweep(&reader, trace_path, configs, threads, max_inst, ckpt_in);
+    return reader.Failed() ? 1 : status;
+  }
+  int status = run_single(&reader, trace_path, configs.empty() ? NULL : configs[0], max_inst, top_n, profile_path,
+                          ckpt_in, ckpt_out, position, spec_depth, delay_spec ? &delay : NULL);
+  return reader.Failed() ? 1 : status;
+}
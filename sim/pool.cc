@@ -0,0 +1,80 @@
+#include "pool.h"
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int threads): workers(threads > 0 ? threads : 1){
+}
+
+void WorkStealingPool::submit(std::function<void()> fn, UINT64 cost){
+  Job job;
+  job.fn = fn;
+  job.cost = cost;
+  pending.push_back(job);
+}
+
+void WorkStealingPool::run(){
+  std::stable_sort(pending.begin(), pending.end(), [](const Job &a, const Job &b){ return a.cost > b.cost; });
+  for(size_t w = 0; w < workers.size(); w++){
+    workers[w].jobs.clear();
+    workers[w].queued_cost = 0;
+  }
+  // longest processing time first: each job to the currently lightest worker
+  for(size_t i = 0; i < pending.size(); i++){
+    size_t lightest = 0;
+    for(size_t w = 1; w < workers.size(); w++){
+      if(workers[w].queued_cost < workers[lightest].queued_cost) lightest = w;
+    }
+    workers[lightest].jobs.push_back(pending[i]);
+    workers[lightest].queued_cost += pending[i].cost;
+  }
+  pending.clear();
+
+  std::vector<std::thread> threads;
+  for(size_t w = 1; w < workers.size(); w++){
+    threads.push_back(std::thread(&WorkStealingPool::work, this, (int)w));
+  }
+  work(0);
+  for(size_t t = 0; t < threads.size(); t++){
+    threads[t].join();
+  }
+}
+
+bool WorkStealingPool::take(int self, Job *job){
+  {
+    Worker &own = workers[self];
+    std::lock_guard<std::mutex> lock(own.m);
+    if(!own.jobs.empty()){
+      *job = own.jobs.front();
+      own.jobs.pop_front();
+      own.queued_cost -= job->cost;
+      return true;
+    }
+  }
+  // steal from the peer with the most queued work; retry if it drained
+  // between looking and locking
+  for(;;){
+    int victim = -1;
+    UINT64 most = 0;
+    for(size_t w = 0; w < workers.size(); w++){
+      std::lock_guard<std::mutex> lock(workers[w].m);
+      if(!workers[w].jobs.empty() && (victim < 0 || workers[w].queued_cost > most)){
+        victim = w;
+        most = workers[w].queued_cost;
+      }
+    }
+    if(victim < 0) return false;
+    Worker &v = workers[victim];
+    std::lock_guard<std::mutex> lock(v.m);
+    if(v.jobs.empty()) continue;
+    *job = v.jobs.front();
+    v.jobs.pop_front();
+    v.queued_cost -= job->cost;
+    return true;
+  }
+}
+
+void WorkStealingPool::work(int self){
+  Job job;
+  while(take(self, &job)){
+    job.fn();
+  }
+}
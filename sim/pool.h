@@ -0,0 +1,43 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include "utils.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs a fixed batch of independent jobs on a pool of threads. Jobs carry an
+// estimated cost: they are dealt out largest first to the least loaded
+// worker, each worker runs its own queue largest first, and a worker whose
+// queue runs dry steals the largest pending job of the most loaded peer, so
+// bad estimates and long tails still even out.
+class WorkStealingPool{
+public:
+  explicit WorkStealingPool(int threads);
+
+  // queue a job; only valid before run()
+  void submit(std::function<void()> fn, UINT64 cost);
+  // run every queued job, return once all have finished
+  void run();
+
+private:
+  struct Job{
+    std::function<void()> fn;
+    UINT64 cost;
+  };
+
+  struct Worker{
+    std::mutex m;
+    std::deque<Job> jobs;    // largest cost at the front
+    UINT64 queued_cost;
+  };
+
+  std::vector<Job> pending;
+  std::vector<Worker> workers;
+
+  bool take(int self, Job *job);
+  void work(int self);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "profile.h"
+#include <vector>
+
+#define PROFILE_INIT_CAPACITY 4096
+
+BranchProfile::BranchProfile(): capacity(PROFILE_INIT_CAPACITY), used(0){
+  table = new BranchProfileEntry[capacity];
+  memset(table, 0, sizeof(BranchProfileEntry) * capacity);
+}
+
+BranchProfile::~BranchProfile(){
+  delete[] table;
+}
+
+void BranchProfile::grow(){
+  BranchProfileEntry *old = table;
+  UINT32 old_capacity = capacity;
+  capacity *= 2;
+  table = new BranchProfileEntry[capacity];
+  memset(table, 0, sizeof(BranchProfileEntry) * capacity);
+  for(UINT32 i = 0; i < old_capacity; i++){
+    if(old[i].execs == 0) continue;
+    UINT32 slot = hash(old[i].pc);
+    while(table[slot].execs != 0){
+      slot = (slot + 1) & (capacity - 1);
+    }
+    table[slot] = old[i];
+  }
+  delete[] old;
+}
+
+static bool by_mispreds(const BranchProfileEntry *a, const BranchProfileEntry *b){
+  if(a->mispreds != b->mispreds) return a->mispreds > b->mispreds;
+  return a->pc < b->pc;
+}
+
+static bool by_pc(const BranchProfileEntry *a, const BranchProfileEntry *b){
+  return a->pc < b->pc;
+}
+
+static void print_providers(FILE *out, const BranchProfileEntry &e){
+  for(int c = 0; c < PROFILE_MAX_COMPONENTS; c++){
+    if(e.provider[c] == 0) continue;
+    if(c == 0){
+      fprintf(out, " base:%.0f%%", 100.0 * e.provider[c] / e.execs);
+    }
+    else{
+      fprintf(out, " T%d:%.0f%%", c, 100.0 * e.provider[c] / e.execs);
+    }
+  }
+}
+
+void BranchProfile::report_top(FILE *out, int n, UINT64 total_mispreds) const{
+  std::vector<const BranchProfileEntry *> entries;
+  for(UINT32 i = 0; i < capacity; i++){
+    if(table[i].execs != 0) entries.push_back(&table[i]);
+  }
+  if((size_t)n > entries.size()) n = entries.size();
+  std::partial_sort(entries.begin(), entries.begin() + n, entries.end(), by_mispreds);
+
+  fprintf(out, "  TOP_%d_MISPREDICTED_BRANCHES (%u static branches)\n", n, used);
+  fprintf(out, "  %-10s %12s %12s %8s %8s  %s\n", "PC", "EXECS", "MISPREDS", "RATE", "SHARE", "PROVIDER");
+  for(int i = 0; i < n; i++){
+    const BranchProfileEntry &e = *entries[i];
+    fprintf(out, "  0x%08x %12llu %12llu %7.2f%% %7.2f%% ", e.pc, (unsigned long long)e.execs,
+            (unsigned long long)e.mispreds, 100.0 * e.mispreds / e.execs,
+            total_mispreds ? 100.0 * e.mispreds / total_mispreds : 0.0);
+    print_providers(out, e);
+    fprintf(out, "\n");
+  }
+}
+
+void BranchProfile::dump(FILE *out) const{
+  std::vector<const BranchProfileEntry *> entries;
+  for(UINT32 i = 0; i < capacity; i++){
+    if(table[i].execs != 0) entries.push_back(&table[i]);
+  }
+  std::sort(entries.begin(), entries.end(), by_pc);
+  for(size_t i = 0; i < entries.size(); i++){
+    const BranchProfileEntry &e = *entries[i];
+    fprintf(out, "0x%08x %llu %llu", e.pc, (unsigned long long)e.execs, (unsigned long long)e.mispreds);
+    for(int c = 0; c < PROFILE_MAX_COMPONENTS; c++){
+      fprintf(out, " %u", e.provider[c]);
+    }
+    fprintf(out, "\n");
+  }
+}
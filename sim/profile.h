@@ -0,0 +1,73 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "utils.h"
+
+// Components a profile entry can attribute a prediction to: the base table
+// plus up to 8 tagged tables. registry.cc checks every registered config
+// against it.
+#define PROFILE_MAX_COMPONENTS 9
+
+struct BranchProfileEntry{
+  UINT32 pc;
+  UINT32 provider[PROFILE_MAX_COMPONENTS]; // [0] base table, [i + 1] tagged table i
+  UINT64 execs;                            // 0 marks an empty slot
+  UINT64 mispreds;
+};
+
+// Per-PC execution/misprediction counts kept in an open-addressing hash
+// table with linear probing, so recording a branch is a hash, usually one
+// probe and a few increments.
+class BranchProfile{
+public:
+  BranchProfile();
+  ~BranchProfile();
+
+  // provider is the predictor's provider component, -1 for the base table
+  void record(UINT32 pc, bool mispred, int provider){
+    UINT32 slot = hash(pc);
+    while(table[slot].execs != 0 && table[slot].pc != pc){
+      slot = (slot + 1) & (capacity - 1);
+    }
+    BranchProfileEntry &e = table[slot];
+    if(e.execs == 0){
+      if((used + 1) * 2 > capacity){
+        grow();
+        record(pc, mispred, provider);
+        return;
+      }
+      e.pc = pc;
+      used++;
+    }
+    update(e, mispred, provider);
+  }
+
+  // the n branches with the most mispredictions, hardest first
+  void report_top(FILE *out, int n, UINT64 total_mispreds) const;
+  // every branch, sorted by PC, one line each so two runs can be diffed
+  void dump(FILE *out) const;
+
+private:
+  BranchProfileEntry *table;
+  UINT32 capacity;
+  UINT32 used;
+
+  UINT32 hash(UINT32 pc) const{
+    return (UINT32)((pc * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+  }
+
+  static void update(BranchProfileEntry &e, bool mispred, int provider){
+    e.execs++;
+    e.mispreds += mispred;
+    if(provider + 1 >= 0 && provider + 1 < PROFILE_MAX_COMPONENTS){
+      e.provider[provider + 1]++;
+    }
+  }
+
+  void grow();
+
+  BranchProfile(const BranchProfile &);
+  BranchProfile &operator=(const BranchProfile &);
+};
+
+#endif
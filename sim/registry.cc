@@ -0,0 +1,85 @@
+#include "registry.h"
+#include "profile.h"
+#include "TageCore.h"
+#include "TageConfig.h"
+
+template<class P>
+static BranchPredictor *create(){
+  // -p/-P would silently drop the providers of the tables past the limit
+  static_assert(P::NUM_TABLES + 1 <= PROFILE_MAX_COMPONENTS, "raise PROFILE_MAX_COMPONENTS for this config");
+  return new PredictorAdapter<P>();
+}
+
+const PredictorFactory predictor_factories[] = {
+  {"TagePredictor",      "base TAGE, 4 tagged tables",             create<TageCore<TageConfig> >},
+  {"TagePredictorOpt",   "TAGE with altpred for new entries",      create<TageCore<TageOptConfig> >},
+  {"TagePredictor8Com",  "TAGE with 8 tagged tables",              create<TageCore<Tage8ComConfig> >},
+  {"LTAGEPredictor",     "TAGE with loop table",                   create<TageCore<LTageConfig> >},
+  {"TAGE_SC_LPredictor", "TAGE with loop table, corrector filter", create<TageCore<TageSCLConfig> >},
+  {"predictor",          "tuned TAGE_SC_L",                        create<TageCore<PredictorConfig> >},
+  {"predictor_path",     "tuned TAGE_SC_L with path history",      create<TageCore<PredictorPathConfig> >},
+  {"predictor_sc",       "tuned TAGE_SC_L, statistical corrector", create<TageCore<PredictorSCConfig> >},
+  {"predictor_local",    "predictor_sc with local history",        create<TageCore<PredictorLocalConfig> >},
+};
+
+const int num_predictor_factories = sizeof(predictor_factories) / sizeof(predictor_factories[0]);
+
+bool apply_predictor_options(BranchPredictor *pred, const char *options){
+  while(options && *options){
+    const char *end = strchr(options, ':');
+    size_t len = end ? (size_t)(end - options) : strlen(options);
+    if(strncmp(options, "hist=", 5) == 0){
+      int lens[64];
+      int n = 0;
+      const char *p = options + 5;
+      while(p < options + len && n < 64){
+        char *next;
+        lens[n++] = strtol(p, &next, 0);
+        if(next == p) break;
+        p = (*next == ',') ? next + 1 : next;
+      }
+      if(!pred->SetHistoryLengths(lens, n)){
+        fprintf(stderr, "history lengths '%.*s' do not fit this predictor\n", (int)len, options);
+        return false;
+      }
+    }
+    else if(strncmp(options, "seed=", 5) == 0){
+      char *next;
+      unsigned long seed = strtoul(options + 5, &next, 0);
+      if(next != options + len || !pred->SetSeed(seed)){
+        fprintf(stderr, "bad or unsupported seed '%.*s'\n", (int)len, options);
+        return false;
+      }
+    }
+    else{
+      fprintf(stderr, "unknown predictor option '%.*s'\n", (int)len, options);
+      return false;
+    }
+    options = end ? end + 1 : NULL;
+  }
+  return true;
+}
+
+BranchPredictor *create_predictor(const char *spec){
+  const char *colon = strchr(spec, ':');
+  size_t name_len = colon ? (size_t)(colon - spec) : strlen(spec);
+  for(int i = 0; i < num_predictor_factories; i++){
+    const char *name = predictor_factories[i].name;
+    if(strlen(name) == name_len && strncmp(name, spec, name_len) == 0){
+      BranchPredictor *pred = predictor_factories[i].create();
+      if(colon && !apply_predictor_options(pred, colon + 1)){
+        delete pred;
+        return NULL;
+      }
+      return pred;
+    }
+  }
+  fprintf(stderr, "unknown config %.*s\n", (int)name_len, spec);
+  return NULL;
+}
+
+void list_predictors(FILE *out){
+  for(int i = 0; i < num_predictor_factories; i++){
+    fprintf(out, "  %-20s %s\n", predictor_factories[i].name, predictor_factories[i].desc);
+  }
+}
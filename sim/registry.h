@@ -0,0 +1,264 @@
+#ifndef _REGISTRY_H_
+#define _REGISTRY_H_
+
+#include "utils.h"
+#include "tracer.h"
+#include <type_traits>
+
+// Type-erased predictor, so a driver can choose among many configurations
+// compiled into the same binary at run time.
+class BranchPredictor{
+public:
+  virtual ~BranchPredictor(){}
+  // an independent predictor in the same state, NULL if P cannot be copied
+  virtual BranchPredictor *Clone() const = 0;
+  virtual bool GetPrediction(UINT32 PC) = 0;
+  virtual void UpdatePredictor(UINT32 PC, bool resolveDir, bool predDir, UINT32 branchTarget) = 0;
+  virtual void TrackOtherInst(UINT32 PC, OpType opType, UINT32 branchTarget) = 0;
+  // predict and update a whole block of records, returns the mispredictions
+  virtual UINT64 PredictBlock(const TraceRecord *recs, size_t n) = 0;
+  // replay group[k] over recs[k][0 .. len) for n <= LOCKSTEP_MAX predictors
+  // stepped together (see PredictorAdapter::PredictLockstep), adding their
+  // mispredictions to mispred[k]; false, replaying nothing, unless every one
+  // is of this predictor's type
+  static const int LOCKSTEP_MAX = 16;
+  virtual bool PredictLockstep(BranchPredictor *const *group, int n, const TraceRecord *const *recs, size_t len,
+                               UINT64 *mispred) = 0;
+  // provider component of the last prediction, -1 for the base table
+  virtual int GetProvider() const = 0;
+  virtual void DumpStats(FILE *out) = 0;
+  // false if the predictor has no such knob or the lengths don't fit it
+  virtual bool SetHistoryLengths(const int *lens, int n) = 0;
+  // reseed the predictor's random source; false if it has none
+  virtual bool SetSeed(UINT32 seed) = 0;
+  // checkpoint of the complete predictor state; false if unsupported or the
+  // data does not belong to this configuration
+  virtual bool SaveState(FILE *out) = 0;
+  virtual bool LoadState(FILE *in) = 0;
+  // speculative mode (see TageCore::PredictSpeculative); MaxInFlight is 0
+  // when the predictor has none
+  virtual int MaxInFlight() const = 0;
+  virtual bool PredictSpeculative(UINT32 PC) = 0;
+  virtual bool ResolveSpeculative(bool resolveDir, UINT32 branchTarget) = 0;
+  // delayed-update mode (see TageCore::PredictDeferred), same slots
+  virtual int PredictDeferred(UINT32 PC, bool resolveDir, bool *predDir) = 0;
+  virtual void UpdateDeferred(int handle, bool resolveDir) = 0;
+};
+
+// Wraps any class with the cbp4 PREDICTOR interface; Clone copy-constructs
+// it, so the predictor state must not own pointers. GetProvider, DumpStats,
+// SetHistoryLengths, SetSeed, SaveState/LoadState, PredictBlock, PredictLockstep and the speculative and
+// delayed-update modes are forwarded when P has them; without PredictBlock or PredictLockstep the records are
+// replayed one by one here, still without a virtual call per branch.
+template<class P>
+class PredictorAdapter : public BranchPredictor{
+public:
+  BranchPredictor *Clone() const override{
+    return clone_of(this, 0);
+  }
+  bool GetPrediction(UINT32 PC) override{
+    return impl.GetPrediction(PC);
+  }
+  void UpdatePredictor(UINT32 PC, bool resolveDir, bool predDir, UINT32 branchTarget) override{
+    impl.UpdatePredictor(PC, resolveDir, predDir, branchTarget);
+  }
+  void TrackOtherInst(UINT32 PC, OpType opType, UINT32 branchTarget) override{
+    impl.TrackOtherInst(PC, opType, branchTarget);
+  }
+  UINT64 PredictBlock(const TraceRecord *recs, size_t n) override{
+    return predict_block_of(&impl, recs, n, 0);
+  }
+  bool PredictLockstep(BranchPredictor *const *group, int n, const TraceRecord *const *recs, size_t len,
+                       UINT64 *mispred) override{
+    P *impls[LOCKSTEP_MAX];
+    if(n > LOCKSTEP_MAX) return false;
+    for(int k = 0; k < n; k++){
+      PredictorAdapter *a = dynamic_cast<PredictorAdapter *>(group[k]);
+      if(a == NULL) return false;
+      impls[k] = &a->impl;
+    }
+    predict_lockstep_of(impls, n, recs, len, mispred, 0);
+    return true;
+  }
+  int GetProvider() const override{
+    return provider_of(&impl, 0);
+  }
+  void DumpStats(FILE *out) override{
+    dump_stats_of(&impl, out, 0);
+  }
+  bool SetHistoryLengths(const int *lens, int n) override{
+    return set_history_lengths_of(&impl, lens, n, 0);
+  }
+  bool SetSeed(UINT32 seed) override{
+    return set_seed_of(&impl, seed, 0);
+  }
+  bool SaveState(FILE *out) override{
+    return save_state_of(&impl, out, 0);
+  }
+  bool LoadState(FILE *in) override{
+    return load_state_of(&impl, in, 0);
+  }
+  int MaxInFlight() const override{
+    return max_in_flight_of(&impl, 0);
+  }
+  bool PredictSpeculative(UINT32 PC) override{
+    return predict_speculative_of(&impl, PC, 0);
+  }
+  bool ResolveSpeculative(bool resolveDir, UINT32 branchTarget) override{
+    return resolve_speculative_of(&impl, resolveDir, branchTarget, 0);
+  }
+  int PredictDeferred(UINT32 PC, bool resolveDir, bool *predDir) override{
+    return predict_deferred_of(&impl, PC, resolveDir, predDir, 0);
+  }
+  void UpdateDeferred(int handle, bool resolveDir) override{
+    update_deferred_of(&impl, handle, resolveDir, 0);
+  }
+
+private:
+  P impl;
+
+  template<class A>
+  static auto clone_of(const A *a, int) -> typename std::enable_if<std::is_copy_constructible<A>::value, BranchPredictor *>::type{
+    return new A(*a);
+  }
+  template<class A>
+  static BranchPredictor *clone_of(const A *a, long){ return NULL; }
+
+  template<class Q>
+  static auto predict_block_of(Q *p, const TraceRecord *recs, size_t n, int) -> decltype(p->PredictBlock(recs, n)){
+    return p->PredictBlock(recs, n);
+  }
+  template<class Q>
+  static UINT64 predict_block_of(Q *p, const TraceRecord *recs, size_t n, long){
+    UINT64 mispred = 0;
+    for(size_t i = 0; i < n; i++){
+      const TraceRecord &rec = recs[i];
+      if(rec.opType == OPTYPE_BRANCH_COND){
+        bool resolveDir = rec.taken != 0;
+        bool predDir = p->GetPrediction(rec.PC);
+        p->UpdatePredictor(rec.PC, resolveDir, predDir, rec.branchTarget);
+        mispred += predDir != resolveDir;
+      }
+      else{
+        p->TrackOtherInst(rec.PC, (OpType)rec.opType, rec.branchTarget);
+      }
+    }
+    return mispred;
+  }
+
+  template<class Q>
+  static auto predict_lockstep_of(Q **g, int n, const TraceRecord *const *recs, size_t len, UINT64 *mispred, int)
+      -> decltype(Q::PredictLockstep(g, n, recs, len, mispred)){
+    Q::PredictLockstep(g, n, recs, len, mispred);
+  }
+  // Each step takes one record of every predictor before moving on. Each
+  // predictor ends up exactly as if it had replayed its records alone, but
+  // the instances share no state, so the core overlaps their table walks
+  // instead of waiting out one dependent chain. The records may be the same
+  // block for all (a sweep) or a block of a different trace each.
+  template<class Q>
+  static void predict_lockstep_of(Q **g, int n, const TraceRecord *const *recs, size_t len, UINT64 *mispred, long){
+    for(size_t i = 0; i < len; i++){
+      for(int k = 0; k < n; k++){
+        const TraceRecord &rec = recs[k][i];
+        if(rec.opType == OPTYPE_BRANCH_COND){
+          bool resolveDir = rec.taken != 0;
+          bool predDir = g[k]->GetPrediction(rec.PC);
+          g[k]->UpdatePredictor(rec.PC, resolveDir, predDir, rec.branchTarget);
+          mispred[k] += predDir != resolveDir;
+        }
+        else{
+          g[k]->TrackOtherInst(rec.PC, (OpType)rec.opType, rec.branchTarget);
+        }
+      }
+    }
+  }
+
+  template<class Q>
+  static auto provider_of(const Q *p, int) -> decltype(p->GetProvider()){ return p->GetProvider(); }
+  template<class Q>
+  static int provider_of(const Q *p, long){ return -1; }
+
+  template<class Q>
+  static auto dump_stats_of(Q *p, FILE *out, int) -> decltype(p->DumpStats(out)){ p->DumpStats(out); }
+  template<class Q>
+  static void dump_stats_of(Q *p, FILE *out, long){}
+
+  template<class Q>
+  static auto set_history_lengths_of(Q *p, const int *lens, int n, int) -> decltype(p->SetHistoryLengths(lens, n)){
+    return p->SetHistoryLengths(lens, n);
+  }
+  template<class Q>
+  static bool set_history_lengths_of(Q *p, const int *lens, int n, long){ return false; }
+
+  template<class Q>
+  static auto set_seed_of(Q *p, UINT32 seed, int) -> decltype(p->SetSeed(seed), true){
+    p->SetSeed(seed);
+    return true;
+  }
+  template<class Q>
+  static bool set_seed_of(Q *p, UINT32 seed, long){ return false; }
+
+  template<class Q>
+  static auto save_state_of(const Q *p, FILE *out, int) -> decltype(p->SaveState(out)){ return p->SaveState(out); }
+  template<class Q>
+  static bool save_state_of(const Q *p, FILE *out, long){ return false; }
+
+  template<class Q>
+  static auto load_state_of(Q *p, FILE *in, int) -> decltype(p->LoadState(in)){ return p->LoadState(in); }
+  template<class Q>
+  static bool load_state_of(Q *p, FILE *in, long){ return false; }
+
+  template<class Q>
+  static auto max_in_flight_of(const Q *p, int) -> decltype(p->MaxInFlight()){ return p->MaxInFlight(); }
+  template<class Q>
+  static int max_in_flight_of(const Q *p, long){ return 0; }
+
+  template<class Q>
+  static auto predict_speculative_of(Q *p, UINT32 PC, int) -> decltype(p->PredictSpeculative(PC)){
+    return p->PredictSpeculative(PC);
+  }
+  template<class Q>
+  static bool predict_speculative_of(Q *p, UINT32 PC, long){ return false; }
+
+  template<class Q>
+  static auto resolve_speculative_of(Q *p, bool dir, UINT32 target, int) -> decltype(p->ResolveSpeculative(dir, target)){
+    return p->ResolveSpeculative(dir, target);
+  }
+  template<class Q>
+  static bool resolve_speculative_of(Q *p, bool dir, UINT32 target, long){ return false; }
+
+  template<class Q>
+  static auto predict_deferred_of(Q *p, UINT32 PC, bool dir, bool *pred, int) -> decltype(p->PredictDeferred(PC, dir, pred)){
+    return p->PredictDeferred(PC, dir, pred);
+  }
+  template<class Q>
+  static int predict_deferred_of(Q *p, UINT32 PC, bool dir, bool *pred, long){ return -1; }
+
+  template<class Q>
+  static auto update_deferred_of(Q *p, int handle, bool dir, int) -> decltype(p->UpdateDeferred(handle, dir)){
+    p->UpdateDeferred(handle, dir);
+  }
+  template<class Q>
+  static void update_deferred_of(Q *p, int handle, bool dir, long){}
+};
+
+struct PredictorFactory{
+  const char *name;
+  const char *desc;
+  BranchPredictor *(*create)();
+};
+
+// the TAGE configurations of TageConfig.h, one per variant in the repo
+extern const PredictorFactory predictor_factories[];
+extern const int num_predictor_factories;
+
+// spec is a configuration name optionally followed by knobs, e.g.
+// "predictor:hist=8,40,200,640" or "predictor:seed=7"; NULL (with a message on stderr) if the name
+// is unknown or a knob doesn't apply
+BranchPredictor *create_predictor(const char *spec);
+// apply the ":knob=..." part of a spec to an existing predictor
+bool apply_predictor_options(BranchPredictor *pred, const char *options);
+void list_predictors(FILE *out);
+
+#endif
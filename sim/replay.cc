@@ -0,0 +1,402 @@
+#include "replay.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <deque>
+#include <random>
+#include <typeinfo>
+
+// everything but the mispredictions
+static void count_block(const TraceRecord *recs, size_t n, ReplayCounts *counts){
+  for(size_t i = 0; i < n; i++){
+    counts->num_inst += recs[i].gap;
+    counts->num_br += recs[i].opType == OPTYPE_BRANCH_COND;
+    counts->num_uncond_br += recs[i].opType != OPTYPE_BRANCH_COND && recs[i].opType != OPTYPE_OP;
+  }
+  counts->num_inst += n;
+}
+
+void replay_block(BranchPredictor *pred, const TraceRecord *recs, size_t n, ReplayCounts *counts,
+                  BranchProfile *profile){
+  if(profile == NULL){
+    // the predictor runs the block itself; only the counting is left here
+    counts->num_mispred += pred->PredictBlock(recs, n);
+    count_block(recs, n, counts);
+    return;
+  }
+  for(size_t i = 0; i < n; i++){
+    const TraceRecord &rec = recs[i];
+    counts->num_inst += rec.gap;
+    if(rec.opType == OPTYPE_BRANCH_COND){
+      bool resolveDir = rec.taken != 0;
+      bool predDir = pred->GetPrediction(rec.PC);
+      pred->UpdatePredictor(rec.PC, resolveDir, predDir, rec.branchTarget);
+      counts->num_br++;
+      counts->num_mispred += predDir != resolveDir;
+      if(profile){
+        profile->record(rec.PC, predDir != resolveDir, pred->GetProvider());
+      }
+    }
+    else{
+      if(rec.opType != OPTYPE_OP){
+        counts->num_uncond_br++;
+      }
+      pred->TrackOtherInst(rec.PC, (OpType)rec.opType, rec.branchTarget);
+    }
+  }
+  counts->num_inst += n;
+}
+
+void replay_lockstep(BranchPredictor *const *group, int n, const TraceRecord *const *recs, size_t len,
+                     ReplayCounts *const *counts){
+  UINT64 mispred[BranchPredictor::LOCKSTEP_MAX] = {0};
+  if(n > 1 && group[0]->PredictLockstep(group, n, recs, len, mispred)){
+    for(int k = 0; k < n; k++){
+      counts[k]->num_mispred += mispred[k];
+      count_block(recs[k], len, counts[k]);
+    }
+    return;
+  }
+  for(int k = 0; k < n; k++){
+    replay_block(group[k], recs[k], len, counts[k], NULL);
+  }
+}
+
+static size_t read_block(TraceReader *reader, TraceRecord *buf, UINT64 max_inst, UINT64 *num_read){
+  size_t want = REPLAY_BLOCK_RECORDS;
+  if(max_inst && max_inst - *num_read < want){
+    want = max_inst - *num_read;
+  }
+  size_t n = want ? reader->GetNextBlock(buf, want) : 0;
+  *num_read += n;
+  return n;
+}
+
+void replay_stream(TraceReader *reader, BranchPredictor *pred, UINT64 max_inst, ReplayCounts *counts,
+                   BranchProfile *profile){
+  std::vector<TraceRecord> block(REPLAY_BLOCK_RECORDS);
+  UINT64 num_read = 0;
+  size_t len;
+  while((len = read_block(reader, block.data(), max_inst, &num_read)) > 0){
+    replay_block(pred, block.data(), len, counts, profile);
+  }
+}
+
+void replay_streams(TraceReader **readers, BranchPredictor **preds, int n, UINT64 max_inst, ReplayCounts *counts){
+  assert(n <= BranchPredictor::LOCKSTEP_MAX);
+  std::vector<std::vector<TraceRecord> > blocks(n, std::vector<TraceRecord>(REPLAY_BLOCK_RECORDS));
+  std::vector<UINT64> num_read(n, 0);
+  std::vector<size_t> len(n);
+  std::vector<bool> done(n, false);
+  for(;;){
+    BranchPredictor *group[BranchPredictor::LOCKSTEP_MAX];
+    const TraceRecord *recs[BranchPredictor::LOCKSTEP_MAX];
+    ReplayCounts *group_counts[BranchPredictor::LOCKSTEP_MAX];
+    int live = 0;
+    size_t common = REPLAY_BLOCK_RECORDS;
+    for(int k = 0; k < n; k++){
+      if(done[k]) continue;
+      len[k] = read_block(readers[k], blocks[k].data(), max_inst, &num_read[k]);
+      if(len[k] == 0){
+        done[k] = true;
+        continue;
+      }
+      group[live] = preds[k];
+      recs[live] = blocks[k].data();
+      group_counts[live] = &counts[k];
+      live++;
+      common = std::min(common, len[k]);
+    }
+    if(live == 0) return;
+    // blocks are full until a trace ends, so only the last block of a trace
+    // leaves records beyond the common length, replayed on their own
+    replay_lockstep(group, live, recs, common, group_counts);
+    for(int k = 0; k < n; k++){
+      if(!done[k] && len[k] > common){
+        replay_block(preds[k], blocks[k].data() + common, len[k] - common, &counts[k], NULL);
+      }
+    }
+  }
+}
+
+// Everything fetched since the oldest unresolved branch, which is at the
+// front; a misprediction makes the front end fetch all the rest again.
+struct SpecWindow{
+  std::deque<TraceRecord> recs;
+  int branches;
+
+  SpecWindow(): branches(0){}
+};
+
+static void resolve_oldest(BranchPredictor *pred, SpecWindow *w, ReplayCounts *counts){
+  const TraceRecord rec = w->recs.front();
+  w->recs.pop_front();
+  w->branches--;
+  if(pred->ResolveSpeculative(rec.taken != 0, rec.branchTarget)){
+    counts->num_mispred++;
+    for(size_t i = 0; i < w->recs.size(); i++){
+      const TraceRecord &r = w->recs[i];
+      if(r.opType == OPTYPE_BRANCH_COND){
+        pred->PredictSpeculative(r.PC);
+        counts->num_squashed++;
+      }
+      else{
+        pred->TrackOtherInst(r.PC, (OpType)r.opType, r.branchTarget);
+      }
+    }
+  }
+  // instructions older than every unresolved branch are never refetched
+  while(!w->recs.empty() && w->recs.front().opType != OPTYPE_BRANCH_COND){
+    w->recs.pop_front();
+  }
+}
+
+void replay_stream_speculative(TraceReader *reader, BranchPredictor *pred, int depth, UINT64 max_inst,
+                               ReplayCounts *counts){
+  std::vector<TraceRecord> block(REPLAY_BLOCK_RECORDS);
+  SpecWindow window;
+  UINT64 num_read = 0;
+  size_t len;
+  while((len = read_block(reader, block.data(), max_inst, &num_read)) > 0){
+    for(size_t i = 0; i < len; i++){
+      const TraceRecord &rec = block[i];
+      counts->num_inst += 1 + rec.gap;
+      if(rec.opType != OPTYPE_BRANCH_COND){
+        if(rec.opType != OPTYPE_OP){
+          counts->num_uncond_br++;
+        }
+        pred->TrackOtherInst(rec.PC, (OpType)rec.opType, rec.branchTarget);
+        if(window.branches) window.recs.push_back(rec);
+        continue;
+      }
+      counts->num_br++;
+      if(window.branches == depth){
+        resolve_oldest(pred, &window, counts);
+      }
+      pred->PredictSpeculative(rec.PC);
+      window.recs.push_back(rec);
+      window.branches++;
+    }
+  }
+  while(window.branches){
+    resolve_oldest(pred, &window, counts);
+  }
+}
+
+bool UpdateDelay::parse(const char *spec){
+  char *end;
+  if(strncmp(spec, "geo:", 4) == 0){
+    kind = GEOMETRIC;
+    min = 0;
+    mean = strtod(spec + 4, &end);
+    max_given = *end == ':';
+    max = max_given ? strtol(end + 1, &end, 0) : (int)(8 * mean);
+    return *end == '\0' && mean > 0 && max >= 0;
+  }
+  max_given = true;
+  min = strtol(spec, &end, 0);
+  if(*end == '-'){
+    kind = UNIFORM;
+    max = strtol(end + 1, &end, 0);
+  }
+  else{
+    kind = FIXED;
+    max = min;
+  }
+  return *end == '\0' && min >= 0 && max >= min;
+}
+
+struct PendingUpdate{
+  UINT64 due;  // branch count at which the update is applied
+  UINT64 seq;
+  int handle;
+  bool resolveDir;
+
+  bool operator>(const PendingUpdate &o) const{
+    return due != o.due ? due > o.due : seq > o.seq;
+  }
+};
+
+void replay_stream_delayed(TraceReader *reader, BranchPredictor *pred, const UpdateDelay &delay,
+                           UINT64 max_inst, ReplayCounts *counts){
+  std::mt19937_64 rng(delay.seed);
+  std::uniform_int_distribution<int> uniform(delay.min, delay.max);
+  std::geometric_distribution<int> geometric(delay.kind == UpdateDelay::GEOMETRIC ? 1.0 / (delay.mean + 1) : 0.5);
+  std::priority_queue<PendingUpdate, std::vector<PendingUpdate>, std::greater<PendingUpdate> > pending;
+
+  std::vector<TraceRecord> block(REPLAY_BLOCK_RECORDS);
+  UINT64 num_read = 0;
+  UINT64 branch = 0;
+  size_t len;
+  while((len = read_block(reader, block.data(), max_inst, &num_read)) > 0){
+    for(size_t i = 0; i < len; i++){
+      const TraceRecord &rec = block[i];
+      counts->num_inst += 1 + rec.gap;
+      if(rec.opType != OPTYPE_BRANCH_COND){
+        if(rec.opType != OPTYPE_OP){
+          counts->num_uncond_br++;
+        }
+        pred->TrackOtherInst(rec.PC, (OpType)rec.opType, rec.branchTarget);
+        continue;
+      }
+      while(!pending.empty() && pending.top().due <= branch){
+        pred->UpdateDeferred(pending.top().handle, pending.top().resolveDir);
+        pending.pop();
+      }
+
+      bool resolveDir = rec.taken != 0;
+      bool predDir;
+      int handle = pred->PredictDeferred(rec.PC, resolveDir, &predDir);
+      assert(handle >= 0);
+      counts->num_br++;
+      counts->num_mispred += predDir != resolveDir;
+
+      int d = delay.min;
+      if(delay.kind == UpdateDelay::UNIFORM){
+        d = uniform(rng);
+      }
+      else if(delay.kind == UpdateDelay::GEOMETRIC){
+        d = std::min(geometric(rng), delay.max);
+      }
+      pending.push(PendingUpdate{branch + d + 1, branch, handle, resolveDir});
+      branch++;
+    }
+  }
+  while(!pending.empty()){
+    pred->UpdateDeferred(pending.top().handle, pending.top().resolveDir);
+    pending.pop();
+  }
+}
+
+// State shared between the decoding thread and the sweep workers. A block is
+// published by bumping generation; it stays valid until pending drops to 0.
+struct SweepShared{
+  std::mutex m;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  const TraceRecord *block;
+  size_t block_len;
+  UINT64 generation;
+  int pending;
+  bool stop;
+};
+
+// Predictors first, first + stride, ... of preds in groups of one type and
+// at most REPLAY_LOCKSTEP_WIDTH, in order of their first member
+static std::vector<std::vector<int> > lockstep_groups(BranchPredictor **preds, int n, int first, int stride){
+  std::vector<std::vector<int> > groups;
+  for(int i = first; i < n; i += stride){
+    size_t g = 0;
+    while(g < groups.size() && (groups[g].size() == REPLAY_LOCKSTEP_WIDTH ||
+                                typeid(*preds[groups[g][0]]) != typeid(*preds[i]))){
+      g++;
+    }
+    if(g == groups.size()) groups.push_back(std::vector<int>());
+    groups[g].push_back(i);
+  }
+  return groups;
+}
+
+// every predictor of groups over the same block
+static void sweep_block(const std::vector<std::vector<int> > &groups, BranchPredictor **preds,
+                        const TraceRecord *block, size_t len, ReplayCounts *counts){
+  for(size_t g = 0; g < groups.size(); g++){
+    BranchPredictor *group[REPLAY_LOCKSTEP_WIDTH];
+    const TraceRecord *recs[REPLAY_LOCKSTEP_WIDTH];
+    ReplayCounts *group_counts[REPLAY_LOCKSTEP_WIDTH];
+    int k = 0;
+    for(int i : groups[g]){
+      group[k] = preds[i];
+      recs[k] = block;
+      group_counts[k] = &counts[i];
+      k++;
+    }
+    replay_lockstep(group, k, recs, len, group_counts);
+  }
+}
+
+static void sweep_worker(SweepShared *sh, BranchPredictor **preds, int n, int first, int stride,
+                         ReplayCounts *counts){
+  std::vector<std::vector<int> > groups = lockstep_groups(preds, n, first, stride);
+  UINT64 seen = 0;
+  for(;;){
+    const TraceRecord *block;
+    size_t len;
+    {
+      std::unique_lock<std::mutex> lock(sh->m);
+      sh->work_cv.wait(lock, [&]{ return sh->generation != seen || sh->stop; });
+      if(sh->generation == seen) return;
+      seen = sh->generation;
+      block = sh->block;
+      len = sh->block_len;
+    }
+    sweep_block(groups, preds, block, len, counts);
+    {
+      std::lock_guard<std::mutex> lock(sh->m);
+      if(--sh->pending == 0){
+        sh->done_cv.notify_one();
+      }
+    }
+  }
+}
+
+void replay_sweep(TraceReader *reader, BranchPredictor **preds, int n, int threads, UINT64 max_inst,
+                  ReplayCounts *counts){
+  std::vector<TraceRecord> bufs[2];
+  bufs[0].resize(REPLAY_BLOCK_RECORDS);
+  bufs[1].resize(REPLAY_BLOCK_RECORDS);
+  UINT64 num_read = 0;
+
+  if(threads > n) threads = n;
+  if(threads <= 1){
+    std::vector<std::vector<int> > groups = lockstep_groups(preds, n, 0, 1);
+    size_t len;
+    while((len = read_block(reader, bufs[0].data(), max_inst, &num_read)) > 0){
+      sweep_block(groups, preds, bufs[0].data(), len, counts);
+    }
+    return;
+  }
+
+  SweepShared sh;
+  sh.block = NULL;
+  sh.block_len = 0;
+  sh.generation = 0;
+  sh.pending = 0;
+  sh.stop = false;
+  std::vector<std::thread> workers;
+  for(int t = 0; t < threads; t++){
+    workers.push_back(std::thread(sweep_worker, &sh, preds, n, t, threads, counts));
+  }
+
+  int cur = 0;
+  size_t len = read_block(reader, bufs[cur].data(), max_inst, &num_read);
+  while(len > 0){
+    {
+      std::lock_guard<std::mutex> lock(sh.m);
+      sh.block = bufs[cur].data();
+      sh.block_len = len;
+      sh.pending = threads;
+      sh.generation++;
+    }
+    sh.work_cv.notify_all();
+    // decode the next block while the workers run this one
+    size_t next_len = read_block(reader, bufs[cur ^ 1].data(), max_inst, &num_read);
+    {
+      std::unique_lock<std::mutex> lock(sh.m);
+      sh.done_cv.wait(lock, [&]{ return sh.pending == 0; });
+    }
+    cur ^= 1;
+    len = next_len;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sh.m);
+    sh.stop = true;
+  }
+  sh.work_cv.notify_all();
+  for(size_t t = 0; t < workers.size(); t++){
+    workers[t].join();
+  }
+}
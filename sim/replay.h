@@ -0,0 +1,95 @@
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include "utils.h"
+#include "tracer.h"
+#include "registry.h"
+#include "profile.h"
+
+// records decoded and handed to the predictors per step
+#define REPLAY_BLOCK_RECORDS 16384
+// predictors of one configuration stepped together (BranchPredictor::
+// PredictLockstep); more than 8 working sets no longer fit the caches
+#define REPLAY_LOCKSTEP_WIDTH 8
+
+struct ReplayCounts{
+  UINT64 num_inst;
+  UINT64 num_br;
+  UINT64 num_uncond_br;
+  UINT64 num_mispred;
+  UINT64 num_squashed; // speculative replay only
+
+  ReplayCounts(): num_inst(0), num_br(0), num_uncond_br(0), num_mispred(0), num_squashed(0){}
+
+  double mpki() const{
+    return num_inst ? 1000.0 * num_mispred / num_inst : 0.0;
+  }
+};
+
+// Run n trace records through pred the way the cbp4 harness does: conditional
+// branches are predicted and then updated, everything else goes to
+// TrackOtherInst. Without a profile the whole block goes through
+// BranchPredictor::PredictBlock. Instructions a branch-only trace dropped (TraceRecord::gap)
+// are counted but not replayed. profile may be NULL.
+void replay_block(BranchPredictor *pred, const TraceRecord *recs, size_t n, ReplayCounts *counts,
+                  BranchProfile *profile);
+
+// replay_block for n predictors at once, group[k] over recs[k][0 .. len)
+// with counts[k]: stepped in lockstep when all are of one configuration,
+// one after the other otherwise
+void replay_lockstep(BranchPredictor *const *group, int n, const TraceRecord *const *recs, size_t len,
+                     ReplayCounts *const *counts);
+
+// Replay the rest of reader's trace (at most max_inst records, 0 for all)
+// through pred.
+void replay_stream(TraceReader *reader, BranchPredictor *pred, UINT64 max_inst, ReplayCounts *counts,
+                   BranchProfile *profile);
+
+// Replay the trace of readers[k] through preds[k] (at most max_inst records
+// each), for n <= BranchPredictor::LOCKSTEP_MAX predictors stepped in
+// lockstep block by block; a trace that ends early leaves the group.
+void replay_streams(TraceReader **readers, BranchPredictor **preds, int n, UINT64 max_inst, ReplayCounts *counts);
+
+// Replay with predictions made up to depth branches ahead of resolution
+// (1 <= depth <= pred->MaxInFlight()): a branch is resolved when the
+// (depth+1)-th branch after it is fetched, and a misprediction squashes the
+// younger predictions, which are then made again from the repaired history,
+// and the other instructions fetched after it go through TrackOtherInst again.
+// counts->num_squashed counts those re-predictions.
+void replay_stream_speculative(TraceReader *reader, BranchPredictor *pred, int depth, UINT64 max_inst,
+                               ReplayCounts *counts);
+
+// How many younger branches are predicted before a branch's update reaches
+// the tables: a fixed count, uniform in [min, max], or min plus a geometric
+// draw with the given mean, capped at max.
+struct UpdateDelay{
+  enum Kind{ FIXED, UNIFORM, GEOMETRIC };
+  Kind kind;
+  int min;
+  int max;
+  double mean;
+  UINT64 seed;
+  bool max_given; // false when max is the geometric default
+
+  UpdateDelay(): kind(FIXED), min(0), max(0), mean(0), seed(1), max_given(true){}
+  // "N", "N-M" or "geo:MEAN[:MAX]" (MAX defaults to 8 * MEAN, which the
+  // caller may lower to what the predictor supports)
+  bool parse(const char *spec);
+};
+
+// Replay with every update applied after the delay drawn for its branch;
+// the history still takes each outcome at once. The largest delay must stay
+// below pred->MaxInFlight(). A delay of 0 is the plain replay.
+void replay_stream_delayed(TraceReader *reader, BranchPredictor *pred, const UpdateDelay &delay,
+                           UINT64 max_inst, ReplayCounts *counts);
+
+// Decode the trace once and feed every block to all n predictors. With
+// threads > 1 each worker thread owns every threads-th predictor, and the
+// calling thread decodes the next block while the workers run this one.
+// Predictors of one configuration on the same thread run in lockstep groups
+// of up to REPLAY_LOCKSTEP_WIDTH.
+// max_inst = 0 replays the whole trace.
+void replay_sweep(TraceReader *reader, BranchPredictor **preds, int n, int threads, UINT64 max_inst,
+                  ReplayCounts *counts);
+
+#endif
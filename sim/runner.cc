@@ -0,0 +1,243 @@
+#include "utils.h"
+#include "tracer.h"
+#include "registry.h"
+#include "replay.h"
+#include "pool.h"
+#include "checkpoint.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <thread>
+#include <algorithm>
+
+// Batch runner: replays every (trace, config) pair as an independent job on a
+// work-stealing thread pool and prints one MPKI table, per trace and mean.
+// With -R every job starts from a fork of the warmed predictor in the
+// checkpoint instead of a cold one, e.g. to compare continuations of the
+// trace the checkpoint was taken on. Jobs of one configuration are bundled,
+// up to REPLAY_LOCKSTEP_WIDTH traces of similar length each, and a bundle's
+// predictors are stepped in lockstep (see replay_streams).
+
+static void usage(const char *prog){
+  fprintf(stderr, "usage: %s [-c config]... [-j threads] [-w lanes] [-n max_instructions] [-R checkpoint]\n"
+                  "          [-L trace_list] [trace...]\n", prog);
+  fprintf(stderr, "  -c spec  configuration to evaluate (repeatable, default: predictor, or the\n");
+  fprintf(stderr, "           checkpoint's configuration with -R)\n");
+  fprintf(stderr, "  -j N     worker threads (default: number of cores)\n");
+  fprintf(stderr, "  -w N     traces replayed in lockstep per job (default: up to %d, fewer when\n", REPLAY_LOCKSTEP_WIDTH);
+  fprintf(stderr, "           there would be fewer jobs than threads); 1 disables lockstep\n");
+  fprintf(stderr, "  -R file  start every job from the predictor state saved in file (tage_sim -S),\n");
+  fprintf(stderr, "           replaying each trace from its beginning\n");
+  fprintf(stderr, "  -L file  read trace paths from file, one per line\n");
+  exit(1);
+}
+
+struct RunnerJob{
+  const char *trace;
+  const char *config;
+  const WarmStart *warm; // NULL for a cold start
+  UINT64 max_inst;
+  ReplayCounts counts;
+  bool ok;
+};
+
+// jobs of one configuration, run side by side
+static void run_bundle(const std::vector<RunnerJob *> &bundle){
+  std::vector<TraceReader> readers(bundle.size());
+  std::vector<TraceReader *> open_readers;
+  std::vector<BranchPredictor *> preds;
+  std::vector<RunnerJob *> jobs;
+  std::vector<ReplayCounts> counts;
+  for(size_t k = 0; k < bundle.size(); k++){
+    RunnerJob *job = bundle[k];
+    if(!readers[k].open(job->trace)){
+      fprintf(stderr, "cannot open trace %s\n", job->trace);
+      continue;
+    }
+    BranchPredictor *pred = job->warm ? job->warm->fork(job->config) : create_predictor(job->config);
+    if(pred == NULL) continue;
+    open_readers.push_back(&readers[k]);
+    preds.push_back(pred);
+    jobs.push_back(job);
+  }
+  counts.resize(jobs.size());
+  if(!jobs.empty()){
+    replay_streams(open_readers.data(), preds.data(), jobs.size(), bundle[0]->max_inst, counts.data());
+  }
+  for(size_t k = 0; k < jobs.size(); k++){
+    jobs[k]->counts = counts[k];
+    jobs[k]->ok = !open_readers[k]->Failed();
+    delete preds[k];
+  }
+}
+
+static UINT64 file_size(const char *path){
+  struct stat st;
+  if(stat(path, &st) != 0) return 0;
+  return st.st_size;
+}
+
+int main(int argc, char *argv[]){
+  std::vector<const char *> configs;
+  std::vector<std::string> traces;
+  UINT64 max_inst = 0;
+  const char *ckpt_in = NULL;
+  int threads = std::thread::hardware_concurrency();
+  int lanes = 0;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-c") == 0 && i + 1 < argc){
+      configs.push_back(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+      threads = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc){
+      lanes = atoi(argv[++i]);
+    }
+    else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+      max_inst = strtoull(argv[++i], NULL, 0);
+    }
+    else if(strcmp(argv[i], "-R") == 0 && i + 1 < argc){
+      ckpt_in = argv[++i];
+    }
+    else if(strcmp(argv[i], "-L") == 0 && i + 1 < argc){
+      FILE *list = fopen(argv[++i], "r");
+      if(list == NULL){
+        fprintf(stderr, "cannot open trace list %s\n", argv[i]);
+        return 1;
+      }
+      char line[4096];
+      while(fgets(line, sizeof(line), list)){
+        line[strcspn(line, "\r\n")] = '\0';
+        if(line[0] != '\0' && line[0] != '#') traces.push_back(line);
+      }
+      fclose(list);
+    }
+    else if(argv[i][0] == '-' && argv[i][1] != '\0'){
+      usage(argv[0]);
+    }
+    else{
+      traces.push_back(argv[i]);
+    }
+  }
+  if(traces.empty()) usage(argv[0]);
+  std::string saved_spec;
+  if(ckpt_in){
+    UINT64 position;
+    if(!read_checkpoint_header(ckpt_in, &saved_spec, &position)) return 1;
+    if(configs.empty()){
+      if(saved_spec.empty()){
+        fprintf(stderr, "%s holds the compiled-in PREDICTOR, name its configuration with -c\n", ckpt_in);
+        return 1;
+      }
+      configs.push_back(saved_spec.c_str());
+    }
+  }
+  if(configs.empty()) configs.push_back("predictor");
+  if(threads < 1) threads = 1;
+
+  // check every spec up front instead of failing inside the workers; with a
+  // checkpoint this also restores it once per configuration
+  WarmStart warm(ckpt_in ? ckpt_in : "");
+  for(size_t c = 0; c < configs.size(); c++){
+    bool ok;
+    if(ckpt_in){
+      BranchPredictor *pred = warm.add(configs[c]) ? warm.fork(configs[c]) : NULL;
+      ok = pred != NULL;
+      delete pred;
+    }
+    else{
+      BranchPredictor *pred = create_predictor(configs[c]);
+      ok = pred != NULL;
+      delete pred;
+    }
+    if(!ok){
+      list_predictors(stderr);
+      return 1;
+    }
+  }
+
+  size_t nt = traces.size(), nc = configs.size();
+  if(lanes <= 0){
+    // as wide as possible while every thread still gets a bundle
+    lanes = max(1, min(REPLAY_LOCKSTEP_WIDTH, (int)(nt * nc / threads)));
+  }
+  lanes = min(lanes, (int)min(nt, (size_t)BranchPredictor::LOCKSTEP_MAX));
+
+  // replay time is roughly proportional to trace length; traces of similar
+  // length go into the same bundle so its lanes finish together
+  std::vector<UINT64> cost(nt);
+  std::vector<size_t> by_cost(nt);
+  for(size_t t = 0; t < nt; t++){
+    cost[t] = file_size(traces[t].c_str());
+    if(max_inst && max_inst * sizeof(TraceRecord) < cost[t]) cost[t] = max_inst * sizeof(TraceRecord);
+    by_cost[t] = t;
+  }
+  std::stable_sort(by_cost.begin(), by_cost.end(), [&](size_t a, size_t b){ return cost[a] > cost[b]; });
+
+  std::vector<RunnerJob> jobs(nt * nc);
+  std::vector<std::vector<RunnerJob *> > bundles;
+  WorkStealingPool pool(threads);
+  for(size_t c = 0; c < nc; c++){
+    for(size_t i = 0; i < nt; i++){
+      size_t t = by_cost[i];
+      RunnerJob &job = jobs[t * nc + c];
+      job.trace = traces[t].c_str();
+      job.config = configs[c];
+      job.warm = ckpt_in ? &warm : NULL;
+      job.max_inst = max_inst;
+      job.ok = false;
+      if(i % lanes == 0) bundles.push_back(std::vector<RunnerJob *>());
+      bundles.back().push_back(&job);
+    }
+  }
+  for(size_t b = 0; b < bundles.size(); b++){
+    UINT64 bundle_cost = 1;
+    for(RunnerJob *job : bundles[b]){
+      bundle_cost += cost[(job - jobs.data()) / nc];
+    }
+    const std::vector<RunnerJob *> *bundle = &bundles[b];
+    pool.submit([bundle]{ run_bundle(*bundle); }, bundle_cost);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  pool.run();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("  %-40s", "TRACE \\ MPKI");
+  for(size_t c = 0; c < nc; c++) printf(" %20s", configs[c]);
+  printf("\n");
+  std::vector<double> sum(nc, 0.0);
+  std::vector<int> ok(nc, 0);
+  UINT64 total_br = 0;
+  for(size_t t = 0; t < nt; t++){
+    printf("  %-40s", traces[t].c_str());
+    for(size_t c = 0; c < nc; c++){
+      const RunnerJob &job = jobs[t * nc + c];
+      if(!job.ok){
+        printf(" %20s", "FAILED");
+        continue;
+      }
+      printf(" %20.4f", job.counts.mpki());
+      sum[c] += job.counts.mpki();
+      ok[c]++;
+      total_br += job.counts.num_br;
+    }
+    printf("\n");
+  }
+  printf("  %-40s", "MEAN");
+  for(size_t c = 0; c < nc; c++){
+    printf(" %20.4f", ok[c] ? sum[c] / ok[c] : 0.0);
+  }
+  printf("\n");
+  printf("  JOBS                 \t : %10zu on %d threads, %d in lockstep\n", jobs.size(), threads, lanes);
+  printf("  ELAPSED_SECONDS      \t : %10.4f\n", elapsed);
+  printf("  BRANCHES_PER_SEC     \t : %10.0f (all jobs)\n", elapsed > 0 ? total_br / elapsed : 0.0);
+
+  for(size_t i = 0; i < jobs.size(); i++){
+    if(!jobs[i].ok) return 1;
+  }
+  return 0;
+}
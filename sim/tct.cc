@@ -0,0 +1,181 @@
+#include "tct.h"
+#include <vector>
+
+static inline UINT32 zigzag(INT32 v){
+  return ((UINT32)v << 1) ^ (UINT32)(v >> 31);
+}
+
+static inline INT32 unzigzag(UINT32 v){
+  return (INT32)(v >> 1) ^ -(INT32)(v & 1);
+}
+
+static void put_varint(std::vector<UINT8> &out, UINT64 v){
+  while(v >= 0x80){
+    out.push_back((UINT8)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((UINT8)v);
+}
+
+// false when the varint runs past end
+static inline bool get_varint(const UINT8 *&p, const UINT8 *end, UINT64 *v){
+  UINT64 r = 0;
+  for(int shift = 0; p < end && shift < 64; shift += 7){
+    UINT8 b = *p++;
+    r |= (UINT64)(b & 0x7f) << shift;
+    if(b < 0x80){
+      *v = r;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t tct_decode_block(const UINT8 *p, const UINT8 *end, TraceRecord *out){
+  TctBlockHeader h;
+  if((size_t)(end - p) < sizeof(h)) return 0;
+  memcpy(&h, p, sizeof(h));
+  if(h.num_records == 0 || h.num_records > TCT_BLOCK_RECORDS || tct_block_size(h) > (size_t)(end - p)){
+    return 0;
+  }
+  size_t n = h.num_records;
+  const UINT8 *op = p + sizeof(h);
+  const UINT8 *dir = op + (n + 1) / 2;
+  const UINT8 *pc = dir + (n + 7) / 8;
+  const UINT8 *pc_end = pc + h.pc_bytes;
+  const UINT8 *target = pc_end;
+  const UINT8 *target_end = target + h.target_bytes;
+  const UINT8 *gap = target_end;
+  const UINT8 *gap_end = gap + h.gap_bytes;
+
+  UINT32 prev_pc = 0;
+  for(size_t i = 0; i < n; i++){
+    TraceRecord &rec = out[i];
+    UINT64 v;
+    rec.opType = (op[i / 2] >> ((i & 1) * 4)) & 15;
+    rec.taken = (dir[i / 8] >> (i & 7)) & 1;
+    if(!get_varint(pc, pc_end, &v)) return 0;
+    rec.PC = prev_pc + unzigzag((UINT32)v);
+    prev_pc = rec.PC;
+    if(!get_varint(target, target_end, &v)) return 0;
+    rec.branchTarget = v ? rec.PC + unzigzag((UINT32)(v - 1)) : 0;
+    rec.gap = 0;
+    if(h.gap_bytes){
+      if(!get_varint(gap, gap_end, &v)) return 0;
+      rec.gap = v;
+    }
+  }
+  return n;
+}
+
+TctWriter::TctWriter(): fp(NULL), pending_gap(0), have_dropped(false), block_len(0), write_ok(true){
+}
+
+TctWriter::~TctWriter(){
+  if(fp) close();
+}
+
+bool TctWriter::open(const char *path, bool branches_only){
+  fp = fopen(path, "wb");
+  if(fp == NULL) return false;
+  memset(&header, 0, sizeof(header));
+  header.magic = TCT_MAGIC;
+  header.version = TCT_VERSION;
+  header.flags = branches_only ? TCT_BRANCHES_ONLY : 0;
+  header.block_records = TCT_BLOCK_RECORDS;
+  pending_gap = 0;
+  have_dropped = false;
+  block_len = 0;
+  write_ok = true;
+  // the real header is written by close() once the counts are known
+  return fwrite(&header, sizeof(header), 1, fp) == 1;
+}
+
+void TctWriter::add(const TraceRecord &rec){
+  // the input may itself be branch-only, its gaps carry over
+  header.num_instructions += 1 + rec.gap;
+  if(!(header.flags & TCT_BRANCHES_ONLY)){
+    push(rec);
+    return;
+  }
+  // gap must fit TraceRecord::gap; past that the last dropped record is kept
+  // to carry what came before it
+  if(pending_gap + 1 + rec.gap > 0xffff){
+    keep_dropped();
+  }
+  // every branch is kept: the unconditional ones still feed path history
+  if(rec.opType == OPTYPE_OP && pending_gap + 1 + rec.gap <= 0xffff){
+    last_dropped = rec;
+    have_dropped = true;
+    pending_gap += 1 + rec.gap;
+    return;
+  }
+  TraceRecord kept = rec;
+  kept.gap = pending_gap + rec.gap;
+  push(kept);
+  pending_gap = 0;
+  have_dropped = false;
+}
+
+// pending_gap counts the last dropped record and its own gap too
+void TctWriter::keep_dropped(){
+  if(!have_dropped) return;
+  TraceRecord kept = last_dropped;
+  kept.gap = pending_gap - 1;
+  push(kept);
+  pending_gap = 0;
+  have_dropped = false;
+}
+
+void TctWriter::push(const TraceRecord &rec){
+  block[block_len++] = rec;
+  header.num_records++;
+  if(block_len == TCT_BLOCK_RECORDS && !write_block()){
+    write_ok = false;
+  }
+}
+
+bool TctWriter::write_block(){
+  if(block_len == 0) return true;
+  std::vector<UINT8> op((block_len + 1) / 2, 0), dir((block_len + 7) / 8, 0), pc, target, gap;
+  TctBlockHeader h;
+  h.num_records = block_len;
+  h.num_instructions = 0;
+  UINT32 prev_pc = 0;
+  bool has_gap = false;
+  for(UINT32 i = 0; i < block_len; i++){
+    has_gap = has_gap || block[i].gap;
+  }
+  for(UINT32 i = 0; i < block_len; i++){
+    const TraceRecord &rec = block[i];
+    op[i / 2] |= (rec.opType & 15) << ((i & 1) * 4);
+    dir[i / 8] |= (rec.taken ? 1 : 0) << (i & 7);
+    put_varint(pc, zigzag((INT32)(rec.PC - prev_pc)));
+    prev_pc = rec.PC;
+    put_varint(target, rec.branchTarget ? (UINT64)zigzag((INT32)(rec.branchTarget - rec.PC)) + 1 : 0);
+    if(has_gap){
+      put_varint(gap, rec.gap);
+    }
+    h.num_instructions += 1 + rec.gap;
+  }
+  h.pc_bytes = pc.size();
+  h.target_bytes = target.size();
+  h.gap_bytes = gap.size();
+  block_len = 0;
+  bool ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+  for(const std::vector<UINT8> *col : {&op, &dir, &pc, &target, &gap}){
+    ok = ok && fwrite(col->data(), 1, col->size(), fp) == col->size();
+  }
+  return ok;
+}
+
+bool TctWriter::close(){
+  // instructions dropped at the very end have no branch to carry them; keep
+  // the last one so the instruction count stays exact
+  keep_dropped();
+  bool ok = write_block() && write_ok;
+  ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+  fp = NULL;
+  return ok;
+}
@@ -0,0 +1,87 @@
+#ifndef _TCT_H_
+#define _TCT_H_
+
+#include "utils.h"
+#include "tracer.h"
+
+// Columnar compressed trace (.tct). The file is a TctHeader followed by
+// blocks of up to TCT_BLOCK_RECORDS records. Each block is a TctBlockHeader
+// followed by its columns, so it can be decoded on its own straight out of
+// an mmap'd file:
+//
+//   op      4 bits per record (OpType)
+//   dir     1 bit per record (taken)
+//   pc      LEB128 varint per record, zigzag(PC - previous PC), the previous
+//           PC starting at 0 in every block
+//   target  LEB128 varint per record, 0 for a zero target, otherwise
+//           zigzag(branchTarget - PC) + 1
+//   gap     LEB128 varint per record, only in blocks where some record has
+//           one: the number of instructions dropped from the trace just
+//           before the record
+//
+// With TCT_BRANCHES_ONLY the converter drops the non-branch (OPTYPE_OP)
+// records and keeps every branch, conditional or not. The dropped ones never
+// reach TrackOtherInst, but are still counted through the decoded record's
+// gap, so instruction counts, MPKI and predictor results stay the same.
+
+#define TCT_MAGIC         0x54435454u // "TTCT"
+#define TCT_VERSION       1
+#define TCT_BLOCK_RECORDS TRACE_READ_BUF_RECORDS
+
+#define TCT_BRANCHES_ONLY 1
+
+struct TctHeader{
+  UINT32 magic;
+  UINT32 version;
+  UINT32 flags;
+  UINT32 block_records;
+  UINT64 num_records;
+  UINT64 num_instructions;
+};
+
+struct TctBlockHeader{
+  UINT32 num_records;
+  UINT32 num_instructions; // records plus their gaps
+  UINT32 pc_bytes;
+  UINT32 target_bytes;
+  UINT32 gap_bytes;
+};
+
+// size of the whole block starting with h, header included
+inline size_t tct_block_size(const TctBlockHeader &h){
+  return sizeof(TctBlockHeader) + (h.num_records + 1) / 2 + (h.num_records + 7) / 8 +
+         h.pc_bytes + h.target_bytes + h.gap_bytes;
+}
+
+// Decode the block at p (at most end - p bytes) into out, which must have
+// room for TCT_BLOCK_RECORDS records. Returns the number of records, 0 if
+// the block is truncated or corrupt.
+size_t tct_decode_block(const UINT8 *p, const UINT8 *end, TraceRecord *out);
+
+// Builds a .tct file record by record; used by the converter.
+class TctWriter{
+public:
+  TctWriter();
+  ~TctWriter();
+
+  bool open(const char *path, bool branches_only);
+  void add(const TraceRecord &rec);
+  // flush the last block and rewrite the header with the final counts
+  bool close();
+
+private:
+  FILE *fp;
+  TctHeader header;
+  UINT64 pending_gap;
+  TraceRecord last_dropped;
+  bool have_dropped;
+  TraceRecord block[TCT_BLOCK_RECORDS];
+  UINT32 block_len;
+  bool write_ok;
+
+  void push(const TraceRecord &rec);
+  void keep_dropped();
+  bool write_block();
+};
+
+#endif
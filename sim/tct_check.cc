@@ -0,0 +1,125 @@
+#include "utils.h"
+#include "tracer.h"
+#include "tct.h"
+#include "registry.h"
+#include "replay.h"
+#include <string>
+#include <vector>
+
+// Round trip of the .tct writer (make check): a synthetic raw trace is
+// converted with -b, then re-encoded as a full and as a branch-only .tct.
+// Every stage must keep the instruction count of the raw trace, both in the
+// file header and summed over the decoded records, and predictor_path, which
+// hashes the unconditional branches into its path history, must mispredict
+// the same on the raw and the -b trace.
+
+// instructions in the header and in the decoded records of path
+static bool count(const char *path, UINT64 *in_header, UINT64 *decoded){
+  FILE *fp = fopen(path, "rb");
+  TctHeader h;
+  bool ok = fp != NULL && fread(&h, sizeof(h), 1, fp) == 1;
+  if(fp) fclose(fp);
+  TraceReader reader;
+  if(!ok || !reader.open(path)) return false;
+  *in_header = h.num_instructions;
+  *decoded = 0;
+  TraceRecord rec;
+  while(reader.GetNextRecord(&rec)){
+    *decoded += 1 + rec.gap;
+  }
+  return true;
+}
+
+// mispredictions of a fresh predictor_path over path, -1 if it cannot run
+static long long mispredictions(const char *path){
+  TraceReader reader;
+  BranchPredictor *pred = create_predictor("predictor_path");
+  if(pred == NULL || !reader.open(path)){
+    delete pred;
+    return -1;
+  }
+  ReplayCounts counts;
+  replay_stream(&reader, pred, 0, &counts, NULL);
+  delete pred;
+  return counts.num_mispred;
+}
+
+static bool convert(const char *from, const char *to, bool branches_only){
+  TraceReader reader;
+  TctWriter writer;
+  if(!reader.open(from) || !writer.open(to, branches_only)) return false;
+  TraceRecord rec;
+  while(reader.GetNextRecord(&rec)){
+    writer.add(rec);
+  }
+  return writer.close();
+}
+
+int main(int argc, char *argv[]){
+  const char *dir = argc > 1 ? argv[1] : "/tmp";
+  std::string raw = std::string(dir) + "/tct_check.raw";
+  std::string stages[3] = {std::string(dir) + "/tct_check.b.tct", std::string(dir) + "/tct_check.full.tct",
+                           std::string(dir) + "/tct_check.bb.tct"};
+
+  // short runs of other instructions between branches, some of them
+  // unconditional, one run longer than a gap can hold, and a tail of other
+  // instructions after the last branch
+  static const UINT8 other_branches[] = {OPTYPE_RET, OPTYPE_INDIRECT_BR_CALL, OPTYPE_BRANCH_UNCOND,
+                                         OPTYPE_INDIRECT_BR, OPTYPE_CALL_DIRECT};
+  std::vector<TraceRecord> trace;
+  UINT32 seed = 1;
+  UINT32 last_target = 0;
+  for(int i = 0; i < 200000; i++){
+    seed = seed * 1103515245 + 12345;
+    int run = i == 1000 ? 70000 : (seed >> 16) % 8;
+    for(int k = 0; k < run; k++){
+      trace.push_back({0x1000u + 4 * k, 0, OPTYPE_OP, 0, 0});
+    }
+    if((seed >> 24) % 4 == 0){
+      UINT32 pc = 0x4000u + 4 * ((seed >> 8) % 32);
+      last_target = pc + 0x100 * ((seed >> 13) % 16);
+      trace.push_back({pc, last_target, other_branches[(seed >> 26) % 5], 1, 0});
+    }
+    // the direction follows the last unconditional target, so the path matters
+    UINT8 taken = (seed >> 20) % 8 ? (last_target >> 8) & 1 : (seed >> 19) & 1;
+    trace.push_back({0x2000u + 4 * (i % 64), 0x3000, OPTYPE_BRANCH_COND, taken, 0});
+  }
+  for(int k = 0; k < 5; k++){
+    trace.push_back({0x1000u + 4 * k, 0, OPTYPE_OP, 0, 0});
+  }
+  FILE *fp = fopen(raw.c_str(), "wb");
+  if(fp == NULL || fwrite(trace.data(), sizeof(TraceRecord), trace.size(), fp) != trace.size()){
+    fprintf(stderr, "cannot write %s\n", raw.c_str());
+    return 1;
+  }
+  fclose(fp);
+
+  bool ok = convert(raw.c_str(), stages[0].c_str(), true) && convert(stages[0].c_str(), stages[1].c_str(), false) &&
+            convert(stages[0].c_str(), stages[2].c_str(), true);
+  if(!ok){
+    fprintf(stderr, "conversion failed\n");
+    return 1;
+  }
+  int failed = 0;
+  for(const std::string &s : stages){
+    UINT64 in_header, decoded;
+    if(!count(s.c_str(), &in_header, &decoded)){
+      fprintf(stderr, "cannot read %s\n", s.c_str());
+      return 1;
+    }
+    bool match = in_header == trace.size() && decoded == trace.size();
+    printf("%-40s %llu %llu (want %llu) %s\n", s.c_str(), (unsigned long long)in_header,
+           (unsigned long long)decoded, (unsigned long long)trace.size(), match ? "ok" : "FAIL");
+    failed += !match;
+  }
+  long long raw_mispred = mispredictions(raw.c_str()), b_mispred = mispredictions(stages[0].c_str());
+  bool match = raw_mispred >= 0 && raw_mispred == b_mispred;
+  printf("%-40s %lld %lld %s\n", "predictor_path raw / -b mispredictions", raw_mispred, b_mispred,
+         match ? "ok" : "FAIL");
+  failed += !match;
+  remove(raw.c_str());
+  for(const std::string &s : stages){
+    remove(s.c_str());
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+#include "utils.h"
+#include "tracer.h"
+#include "tct.h"
+#include <vector>
+
+// Converts a trace (raw, .gz, stdin or .tct) into the columnar .tct format,
+// or with -d expands a .tct back into raw records.
+
+static void usage(const char *prog){
+  fprintf(stderr, "usage: %s [-b] <trace | -> <out.tct>\n", prog);
+  fprintf(stderr, "       %s -d <in.tct> <out_raw>\n", prog);
+  fprintf(stderr, "  -b  keep only branches (drop OPTYPE_OP records); dropped instructions are still counted\n");
+  fprintf(stderr, "  -d  decode to the raw 12-byte record format\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]){
+  bool branches_only = false;
+  bool decode = false;
+  const char *paths[2];
+  int npaths = 0;
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-b") == 0){
+      branches_only = true;
+    }
+    else if(strcmp(argv[i], "-d") == 0){
+      decode = true;
+    }
+    else if(argv[i][0] == '-' && argv[i][1] != '\0'){
+      usage(argv[0]);
+    }
+    else if(npaths < 2){
+      paths[npaths++] = argv[i];
+    }
+    else{
+      usage(argv[0]);
+    }
+  }
+  if(npaths != 2 || (decode && branches_only)) usage(argv[0]);
+
+  TraceReader reader;
+  if(!reader.open(paths[0])){
+    fprintf(stderr, "cannot open trace %s\n", paths[0]);
+    return 1;
+  }
+  std::vector<TraceRecord> block(TCT_BLOCK_RECORDS);
+  UINT64 records = 0;
+  size_t n;
+
+  if(decode){
+    FILE *out = fopen(paths[1], "wb");
+    if(out == NULL){
+      fprintf(stderr, "cannot write %s\n", paths[1]);
+      return 1;
+    }
+    while((n = reader.GetNextBlock(block.data(), block.size())) > 0){
+      for(size_t i = 0; i < n; i++){
+        if(block[i].gap){
+          fprintf(stderr, "%s is a branch-only trace, it has no raw form\n", paths[0]);
+          fclose(out);
+          return 1;
+        }
+      }
+      if(fwrite(block.data(), sizeof(TraceRecord), n, out) != n){
+        fprintf(stderr, "write error on %s\n", paths[1]);
+        fclose(out);
+        return 1;
+      }
+      records += n;
+    }
+    fclose(out);
+    fprintf(stderr, "%llu records\n", (unsigned long long)records);
+    return reader.Failed() ? 1 : 0;
+  }
+
+  TctWriter writer;
+  if(!writer.open(paths[1], branches_only)){
+    fprintf(stderr, "cannot write %s\n", paths[1]);
+    return 1;
+  }
+  while((n = reader.GetNextBlock(block.data(), block.size())) > 0){
+    for(size_t i = 0; i < n; i++){
+      writer.add(block[i]);
+    }
+    records += n;
+  }
+  if(!writer.close()){
+    fprintf(stderr, "write error on %s\n", paths[1]);
+    return 1;
+  }
+  fprintf(stderr, "%llu records\n", (unsigned long long)records);
+  return reader.Failed() ? 1 : 0;
+}
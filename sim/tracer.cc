@@ -0,0 +1,197 @@
+#include "tracer.h"
+#include "tct.h"
+#include <string>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+TraceReader::TraceReader(): fp(NULL), is_pipe(false), failed(false), map(NULL), map_len(0), map_pos(NULL), map_end(NULL),
+                            buf_len(0), buf_pos(0){
+}
+
+TraceReader::~TraceReader(){
+  close();
+}
+
+bool TraceReader::open(const char *path){
+  close();
+  size_t len = strlen(path);
+  if(strcmp(path, "-") == 0){
+    fp = stdin;
+  }
+  else if(len > 3 && strcmp(path + len - 3, ".gz") == 0){
+    // gzip would only fail once the replay has started reading
+    if(access(path, R_OK) != 0) return false;
+    // single-quoted for the shell, a quote in the path becomes '\''
+    string cmd = "gzip -dc '";
+    for(const char *p = path; *p; p++){
+      cmd += *p == '\'' ? string("'\\''") : string(1, *p);
+    }
+    cmd += "'";
+    fp = popen(cmd.c_str(), "r");
+    is_pipe = true;
+  }
+  else if(open_tct(path)){
+    return true;
+  }
+  else{
+    fp = fopen(path, "rb");
+  }
+  return fp != NULL;
+}
+
+// map path if it is a .tct file; false leaves it to be read as a raw trace
+bool TraceReader::open_tct(const char *path){
+  int fd = ::open(path, O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  TctHeader h;
+  if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || (size_t)st.st_size < sizeof(h) ||
+     pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || h.magic != TCT_MAGIC){
+    ::close(fd);
+    return false;
+  }
+  if(h.version != TCT_VERSION || h.block_records > TCT_BLOCK_RECORDS){
+    fprintf(stderr, "%s: unsupported .tct version %u\n", path, h.version);
+    ::close(fd);
+    return false;
+  }
+  void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if(p == MAP_FAILED) return false;
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+  map = (const UINT8 *)p;
+  map_len = st.st_size;
+  map_pos = map + sizeof(h);
+  map_end = map + map_len;
+  return true;
+}
+
+void TraceReader::close(){
+  if(map){
+    munmap((void *)map, map_len);
+    map = NULL;
+    map_len = 0;
+    map_pos = map_end = NULL;
+  }
+  buf_len = 0;
+  buf_pos = 0;
+  failed = false;
+  if(fp == NULL) return;
+  if(is_pipe){
+    pclose(fp);
+  }
+  else if(fp != stdin){
+    fclose(fp);
+  }
+  fp = NULL;
+  is_pipe = false;
+}
+
+size_t TraceReader::decode_tct_block(TraceRecord *out){
+  if(map_pos >= map_end) return 0;
+  size_t n = tct_decode_block(map_pos, map_end, out);
+  if(n == 0){
+    fprintf(stderr, "corrupt .tct block at offset %zu\n", (size_t)(map_pos - map));
+    map_pos = map_end;
+    failed = true;
+    return 0;
+  }
+  TctBlockHeader h;
+  memcpy(&h, map_pos, sizeof(h));
+  map_pos += tct_block_size(h);
+  return n;
+}
+
+size_t TraceReader::GetNextBlock(TraceRecord *out, size_t max){
+  size_t n = min(buf_len - buf_pos, max);
+  memcpy(out, buf + buf_pos, n * sizeof(TraceRecord));
+  buf_pos += n;
+  if(map){
+    // whole blocks go straight into out, only a partial one through buf
+    while(max - n >= TCT_BLOCK_RECORDS){
+      size_t got = decode_tct_block(out + n);
+      if(got == 0) return n;
+      n += got;
+    }
+    while(n < max && refill()){
+      size_t step = min(buf_len, max - n);
+      memcpy(out + n, buf, step * sizeof(TraceRecord));
+      buf_pos = step;
+      n += step;
+    }
+  }
+  else if(n < max){
+    n += read_records(out + n, max - n);
+  }
+  return n;
+}
+
+// fread from fp; at the end of the stream a gzip pipe is closed here so its
+// exit status can be checked
+size_t TraceReader::read_records(TraceRecord *out, size_t max){
+  if(fp == NULL) return 0;
+  size_t n = fread(out, sizeof(TraceRecord), max, fp);
+  if(n == max) return n;
+  if(ferror(fp)){
+    fprintf(stderr, "trace read error\n");
+    failed = true;
+  }
+  if(is_pipe){
+    int status = pclose(fp);
+    fp = NULL;
+    is_pipe = false;
+    if(status != 0){
+      fprintf(stderr, "gzip -dc failed on the trace (status %d)\n", status);
+      failed = true;
+    }
+  }
+  return n;
+}
+
+UINT64 TraceReader::Skip(UINT64 n){
+  UINT64 skipped = 0;
+  for(;;){
+    while(buf_pos < buf_len && skipped + 1 + buf[buf_pos].gap <= n){
+      skipped += 1 + buf[buf_pos].gap;
+      buf_pos++;
+    }
+    if(buf_pos < buf_len || skipped == n) return skipped;
+
+    if(map){
+      while(map_end - map_pos >= (ptrdiff_t)sizeof(TctBlockHeader)){
+        TctBlockHeader h;
+        memcpy(&h, map_pos, sizeof(h));
+        if(skipped + h.num_instructions > n) break;
+        skipped += h.num_instructions;
+        map_pos += min(tct_block_size(h), (size_t)(map_end - map_pos));
+      }
+    }
+    else if(fp != NULL && !is_pipe && fp != stdin){
+      // raw records carry no gap, one record per instruction
+      off_t here = ftello(fp);
+      struct stat st;
+      if(here >= 0 && fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode)){
+        UINT64 left = (st.st_size - here) / sizeof(TraceRecord);
+        UINT64 step = min(left, n - skipped);
+        if(fseeko(fp, here + (off_t)(step * sizeof(TraceRecord)), SEEK_SET) == 0){
+          skipped += step;
+          if(skipped == n || step == left) return skipped;
+        }
+      }
+    }
+    if(!refill()) return skipped;
+  }
+}
+
+bool TraceReader::refill(){
+  if(map){
+    buf_len = decode_tct_block(buf);
+  }
+  else{
+    buf_len = read_records(buf, TRACE_READ_BUF_RECORDS);
+  }
+  buf_pos = 0;
+  return buf_len > 0;
+}
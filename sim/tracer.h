@@ -0,0 +1,84 @@
+#ifndef _TRACER_H_
+#define _TRACER_H_
+
+#include "utils.h"
+
+// Instruction classes reported by the trace. Conditional branches go through
+// GetPrediction/UpdatePredictor, everything else through TrackOtherInst.
+typedef enum {
+  OPTYPE_OP               = 2,
+  OPTYPE_RET              = 3,
+  OPTYPE_BRANCH_COND      = 4,
+  OPTYPE_INDIRECT_BR_CALL = 5,
+  OPTYPE_BRANCH_UNCOND    = 6,
+  OPTYPE_INDIRECT_BR      = 7,
+  OPTYPE_CALL_DIRECT      = 8,
+  OPTYPE_MAX              = 9
+} OpType;
+
+// On-disk record of the raw trace format: one little-endian record per
+// dynamic instruction, no header. Also what the reader decodes .tct blocks
+// into, where gap counts the instructions a branch-only trace dropped just
+// before this record; raw traces must leave it 0.
+struct TraceRecord{
+  UINT32 PC;
+  UINT32 branchTarget;
+  UINT8  opType;
+  UINT8  taken;
+  UINT16 gap;
+};
+
+#define TRACE_READ_BUF_RECORDS 4096
+
+class TraceReader{
+public:
+  TraceReader();
+  ~TraceReader();
+
+  // path "-" reads stdin, a ".gz" suffix is decompressed through gzip -dc,
+  // and a .tct file (recognized by its header) is mmap'd and decoded block
+  // by block into the reader's own buffer or straight into the caller's.
+  // False if the file cannot be read.
+  bool open(const char *path);
+  void close();
+
+  bool GetNextRecord(TraceRecord *rec){
+    if(buf_pos == buf_len && !refill()){
+      return false;
+    }
+    *rec = buf[buf_pos++];
+    return true;
+  }
+
+  // up to max records into out, fewer only at the end of the trace
+  size_t GetNextBlock(TraceRecord *out, size_t max);
+
+  // drop the records of the next n instructions; seeks when the trace is a
+  // plain file, hops whole blocks of a .tct, otherwise reads past them.
+  // Returns how many instructions were actually skipped, less than n at the
+  // end of the trace or when a record with a gap straddles n.
+  UINT64 Skip(UINT64 n);
+
+  // the trace ended early on an error (already reported on stderr): a read
+  // error, a corrupt .tct block or gzip exiting with an error
+  bool Failed() const{ return failed; }
+
+private:
+  FILE *fp;
+  bool is_pipe;
+  bool failed;
+  const UINT8 *map;     // mmap'd .tct file, NULL otherwise
+  size_t map_len;
+  const UINT8 *map_pos; // next block to decode
+  const UINT8 *map_end;
+  size_t buf_len;
+  size_t buf_pos;
+  TraceRecord buf[TRACE_READ_BUF_RECORDS];
+
+  bool refill();
+  size_t read_records(TraceRecord *out, size_t max);
+  bool open_tct(const char *path);
+  size_t decode_tct_block(TraceRecord *out);
+};
+
+#endif
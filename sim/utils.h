@@ -0,0 +1,41 @@
+#ifndef _UTILS_H_
+#define _UTILS_H_
+
+// Minimal stand-in for the cbp4 framework's sim/utils.h, providing exactly
+// what the predictors in this repo rely on so they build without a cbp4
+// checkout.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
+
+using namespace std;
+
+typedef unsigned char      UINT8;
+typedef unsigned short     UINT16;
+typedef unsigned int       UINT32;
+typedef int                INT32;
+typedef unsigned long long UINT64;
+typedef long long          INT64;
+typedef unsigned long long COUNTER;
+
+#define NOT_TAKEN 0
+#define TAKEN     1
+
+#define FAILURE   0
+#define SUCCESS   1
+
+static inline UINT32 SatIncrement(UINT32 x, UINT32 max){
+  if(x < max) return x + 1;
+  return x;
+}
+
+static inline UINT32 SatDecrement(UINT32 x){
+  if(x > 0) return x - 1;
+  return x;
+}
+
+#endif